@@ -14,6 +14,7 @@
 #include "game_aux.h"
 #include "game_ext.h"
 #include "game_private.h"
+#include "game_solver.h"
 #include "game_struct.h"
 #include "queue.h"
 
@@ -66,6 +67,7 @@ bool game_equal(cgame g1, cgame g2, bool ignore_orientation) {
 void game_delete(game g) {
   if (!g) return;
   free(g->squares);
+  _solver_warm_delete(g->warm);
   queue_free_full(g->undo_stack, free);
   queue_free_full(g->redo_stack, free);
   free(g);
@@ -79,6 +81,9 @@ void game_set_piece_shape(game g, uint i, uint j, shape s) {
   assert(j < g->nb_cols);
   assert(s >= 0 && s < NB_SHAPES);
   SHAPE(g, i, j) = s;
+  // the solutions depend on the shapes, nothing kept about them holds
+  _solver_warm_delete(g->warm);
+  g->warm = NULL;
 }
 
 /* ************************************************************************** */
@@ -89,6 +94,7 @@ void game_set_piece_orientation(game g, uint i, uint j, direction o) {
   assert(j < g->nb_cols);
   assert(o >= 0 && o < NB_DIRS);
   ORIENTATION(g, i, j) = o;
+  _solver_warm_update(g->warm, INDEX(g, i, j), o);
 }
 
 /* ************************************************************************** */
@@ -120,6 +126,7 @@ void game_play_move(game g, uint i, uint j, int nb_quarter_turns) {
   direction old = ORIENTATION(g, i, j);
   direction new = MODULO(old + nb_quarter_turns, NB_DIRS);
   ORIENTATION(g, i, j) = new;
+  _solver_warm_update(g->warm, INDEX(g, i, j), new);
 
   // save history
   _stack_clear(g->redo_stack);
@@ -46,6 +46,7 @@ game game_new_empty_ext(uint nb_rows, uint nb_cols, bool wrapping) {
   g->nb_rows = nb_rows;
   g->nb_cols = nb_cols;
   g->wrapping = wrapping;
+  g->warm = NULL;
   g->squares = (square*)calloc(g->nb_rows * g->nb_cols, sizeof(square));
   assert(g->squares);
   for (uint i = 0; i < g->nb_rows; i++)
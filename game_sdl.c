@@ -20,6 +20,8 @@
 #define CORNER_IMG "res/corner.png"
 #define TEE_IMG "res/tee.png"
 #define CROSS_IMG "res/cross.png"
+#define SOLVER_SLICE \
+  20000  // Noeuds de recherche par image, pour garder l'affichage fluide
 
 typedef enum { STATE_MENU, STATE_GAME, STATE_HELP } GameState;
 typedef enum { TAB_COMMANDS, TAB_SHORTCUTS, TAB_TIPS } HelpTab;
@@ -47,6 +49,7 @@ struct Env_t {
   int redo_count;
   float transition_alpha;
   bool solution_shown;
+  game_solver solver;         // Recherche en cours (touche S), ou NULL
   Button menu_buttons[3];     // Jouer, Aide, Quitter
   Button toolbar_buttons[1];  // Aide
   SDL_Window* help_popup;
@@ -81,6 +84,7 @@ Env* init(SDL_Window* win, SDL_Renderer* ren, int argc, char* argv[]) {
   env->current_tab = TAB_COMMANDS;  // Onglet par défaut
   strcpy(env->status_message, "Bienvenue dans le Puzzle Néon !");
   env->solution_shown = false;
+  env->solver = NULL;
 
   SDL_Surface* bg_surface = IMG_Load(BACKGROUND);
   if (!bg_surface) {
@@ -305,9 +309,9 @@ void render_help_popup(SDL_Renderer* ren, Env* env) {
           "H : Afficher/fermer cette aide", "M : Melanger la grille",
           "S : Afficher la solution",       "N : Nouveau jeu",
           "C : Compter les solutions",      "R : Retour au menu",
-          "Echap : Fermer cette aide"};
+          "I : Indice (tourne une piece)",  "Echap : Fermer cette aide"};
       y_offset += line_spacing;
-      for (int i = 0; i < 7; i++) {
+      for (int i = 0; i < 8; i++) {
         SDL_Surface* surf =
             TTF_RenderUTF8_Blended(font, shortcuts_text[i], text_color);
         SDL_Texture* tex = SDL_CreateTextureFromSurface(ren, surf);
@@ -493,6 +497,30 @@ void close_help_window(Env* env) {
   }
 }
 
+// Abandonne la recherche en cours, s'il y en a une
+void stop_solver(Env* env) {
+  game_solver_delete(env->solver);
+  env->solver = NULL;
+}
+
+void update(SDL_Window* win, SDL_Renderer* ren, Env* env) {
+  if (!env->solver) return;
+  // une tranche de recherche par image, la suite à l'image suivante
+  game_solver_state state = game_solver_step(env->solver, SOLVER_SLICE);
+  uint nb_fixed = game_solver_best(env->solver, env->g);
+  if (state == GAME_SOLVER_SOLVED) {
+    strcpy(env->status_message, "Solution affichée !");
+    env->solution_shown = true;
+    stop_solver(env);
+  } else if (state == GAME_SOLVER_NO_SOLUTION) {
+    strcpy(env->status_message, "Pas de solution");
+    stop_solver(env);
+  } else {
+    sprintf(env->status_message, "Recherche : %u pièces placées (%llu noeuds)",
+            nb_fixed, (unsigned long long)game_solver_nb_nodes(env->solver));
+  }
+}
+
 bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e) {
   int w, h;
   SDL_GetWindowSize(win, &w, &h);
@@ -513,6 +541,8 @@ bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e) {
         break;
       case SDLK_z:
         if (ctrl && env->state == STATE_GAME) {
+          // la recherche en cours écraserait le coup à l'image suivante
+          stop_solver(env);
           if (env->move_count > 0) {
             Move m = env->move_history[--env->move_count];
             game_play_move(env->g, m.i, m.j, -m.dir);
@@ -525,6 +555,7 @@ bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e) {
         break;
       case SDLK_y:
         if (ctrl && env->state == STATE_GAME) {
+          stop_solver(env);
           if (env->redo_count > 0) {
             Move m = env->move_history[env->move_count++];
             game_play_move(env->g, m.i, m.j, m.dir);
@@ -561,25 +592,41 @@ bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e) {
         break;
       case SDLK_m:
         if (env->state == STATE_GAME) {
+          stop_solver(env);
           game_shuffle_orientation(env->g);
           strcpy(env->status_message, "Grille mélangée !");
           env->move_count = env->redo_count = 0;
         }
         break;
       case SDLK_s:
+        if (env->state == STATE_GAME && !env->solver) {
+          // la recherche avance par tranches dans update, sans bloquer
+          // l'affichage
+          env->solver = game_solver_new(env->g);
+          strcpy(env->status_message, "Recherche en cours...");
+          env->move_count = env->redo_count = 0;
+        }
+        break;
+      case SDLK_i:
         if (env->state == STATE_GAME) {
-          if (game_solve(env->g)) {
-            strcpy(env->status_message, "Solution affichée !");
-            env->solution_shown = true;
-            render(win, ren, env);
+          // indice : la pièce est tournée, le coup peut être annulé
+          stop_solver(env);
+          uint i, j;
+          direction o;
+          if (game_hint(env->g, &i, &j, &o)) {
+            int dir = (o - game_get_piece_orientation(env->g, i, j) + 4) % 4;
+            game_play_move(env->g, i, j, dir);
+            add_move(env, i, j, dir);
+            sprintf(env->status_message, "Indice : pièce (%u,%u) tournée", i,
+                    j);
           } else {
-            strcpy(env->status_message, "Pas de solution");
+            strcpy(env->status_message, "Pas d'indice");
           }
-          env->move_count = env->redo_count = 0;
         }
         break;
       case SDLK_n:
         if (env->state == STATE_GAME) {
+          stop_solver(env);
           game_delete(env->g);
           env->g = game_random(rand() % 5 + 4, rand() % 5 + 4, false, 2, 3);
           if (!env->g) {
@@ -603,6 +650,7 @@ bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e) {
         break;
       case SDLK_r:
         if (env->state == STATE_GAME) {
+          stop_solver(env);
           env->state = STATE_MENU;
           strcpy(env->status_message, "Retour au menu");
         }
@@ -669,6 +717,7 @@ bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e) {
             if (e->button.button == SDL_BUTTON_LEFT ||
                 e->button.button == SDL_BUTTON_RIGHT) {
               env->solution_shown = false;
+              stop_solver(env);
               game_play_move(env->g, i, j, dir);
               add_move(env, i, j, dir);
             }
@@ -752,6 +801,7 @@ void clean(SDL_Window* win, SDL_Renderer* ren, Env* env) {
   SDL_DestroyTexture(env->background);
   for (int i = 0; i < 6; i++) SDL_DestroyTexture(env->shapes[i]);
   game_delete(env->g);
+  game_solver_delete(env->solver);
   free(env->move_history);
   free(env);
 }
\ No newline at end of file
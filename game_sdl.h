@@ -59,6 +59,7 @@ Env* init(SDL_Window* win, SDL_Renderer* ren, int argc, char* argv[]);
 void render(SDL_Window* win, SDL_Renderer* ren, Env* env);
 void clean(SDL_Window* win, SDL_Renderer* ren, Env* env);
 bool process(SDL_Window* win, SDL_Renderer* ren, Env* env, SDL_Event* e);
+void update(SDL_Window* win, SDL_Renderer* ren, Env* env);
 
 /* **************************************************************** */
 
@@ -15,10 +15,54 @@
 #include "string.h"
 
 int main(int argc, char *argv[]) {
+  char *prog = argv[0];
+
+  // Option -j <nb_threads>[:<depth>] : comptage des solutions (ou résolution
+  // -P, -T) sur plusieurs threads, l'arbre étant découpé en tâches après depth
+  // décisions pour le comptage
+  // Option -C <dir> : solutions conservées sur disque d'un appel à l'autre
+  // Option -t <secondes> : durée de la recherche locale (-l)
+  uint nb_threads = 1, split_depth = 0;
+  double time_limit = 10.0;
+  while (argc >= 3 &&
+         (strcmp(argv[1], "-j") == 0 || strcmp(argv[1], "-C") == 0 ||
+          strcmp(argv[1], "-t") == 0)) {
+    if (argv[1][1] == 'j') {
+      nb_threads = atoi(argv[2]);
+      char *depth = strchr(argv[2], ':');
+      if (depth) split_depth = atoi(depth + 1);
+    } else if (argv[1][1] == 't')
+      time_limit = atof(argv[2]);
+    else
+      game_cache_set_dir(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+
   // Vérifier les arguments
   if (argc < 3 || argc > 4) {
-    fprintf(stderr, "Usage: %s <option> <input> [<output>]\n", argv[0]);
-    fprintf(stderr, "Options: -s (solve), -c (count solutions)\n");
+    fprintf(stderr,
+            "Usage: %s [-j <nb_threads>[:<depth>]] [-C <cache_dir>] "
+            "[-t <seconds>] <option> <input> [<output>]\n",
+            prog);
+    fprintf(stderr,
+            "Options: -s (solve), -S (solve with SAT), -c (count solutions),\n"
+            "         -u (has a unique solution?), -d (export DIMACS),\n"
+            "         -p (presolve report), -P (solve with a portfolio of\n"
+            "         strategies, one per thread), -T (solve by tiles),\n"
+            "         -l (local search, keeps the best state found),\n"
+            "         -z (decision diagram of all the solutions, saved to\n"
+            "         <output>), -e (estimate the number of solutions)\n");
+    fprintf(stderr,
+            "         -j N : count or solve (-P, -T) with N threads (0 = all "
+            "cores)\n");
+    fprintf(stderr,
+            "         -j N:D : count with N threads, splitting the search "
+            "after D decisions\n");
+    fprintf(stderr, "         -C DIR : keep the solutions found in DIR\n");
+    fprintf(stderr,
+            "         -t S : time given to the local search (-l), in seconds "
+            "(10 by default)\n");
     return EXIT_FAILURE;
   }
 
@@ -30,9 +74,21 @@ int main(int argc, char *argv[]) {
   }
 
   // Traiter l'option
-  if (strcmp(argv[1], "-s") == 0) {
-    // Option -s : trouver une solution
-    if (!game_solve(g)) {
+  if (strcmp(argv[1], "-s") == 0 || strcmp(argv[1], "-S") == 0 ||
+      strcmp(argv[1], "-P") == 0 || strcmp(argv[1], "-T") == 0) {
+    // Option -s : trouver une solution (-S : avec le solveur SAT, -P : en
+    // parallèle avec plusieurs stratégies, sur nb_threads threads, -T : par
+    // tuiles remplies sur nb_threads threads)
+    bool solved;
+    if (argv[1][1] == 'S')
+      solved = game_solve_sat(g);
+    else if (argv[1][1] == 'P')
+      solved = game_solve_portfolio(g, nb_threads);
+    else if (argv[1][1] == 'T')
+      solved = game_solve_tiled(g, 0, nb_threads);
+    else
+      solved = game_solve(g);
+    if (!solved) {
       game_delete(g);
       return EXIT_FAILURE;  // Pas de solution
     }
@@ -44,9 +100,75 @@ int main(int argc, char *argv[]) {
       game_print(g);
     }
 
+  } else if (strcmp(argv[1], "-l") == 0) {
+    // Option -l : recherche locale pendant time_limit secondes ; le meilleur
+    // état trouvé est sauvegardé même s'il n'est pas une solution
+    uint nb_unmatched;
+    bool solved = game_solve_local(g, time_limit, &nb_unmatched);
+    fprintf(stderr, "%u demi-arête(s) non appariée(s)%s\n", nb_unmatched,
+            solved ? "" : ", jeu non résolu");
+    if (argc == 4) {
+      game_save(g, argv[3]);
+    } else {
+      game_print(g);
+    }
+    if (!solved) {
+      game_delete(g);
+      return EXIT_FAILURE;
+    }
+
+  } else if (strcmp(argv[1], "-z") == 0) {
+    // Option -z : diagramme de toutes les solutions, sauvegardé dans le
+    // fichier de sortie ; nombre de solutions, taille du diagramme et nombre
+    // de cases imposées
+    game_zdd z = game_zdd_new(g);
+    if (!z) {
+      fprintf(stderr, "Erreur : grille trop large pour le diagramme\n");
+      game_delete(g);
+      return EXIT_FAILURE;
+    }
+    uint n = game_nb_rows(g) * game_nb_cols(g);
+    bool *forced = (bool *)malloc(n * sizeof(bool));
+    direction *dirs = (direction *)malloc(n * sizeof(direction));
+    assert(n == 0 || (forced && dirs));
+    printf("%llu solution(s), %u noeud(s), %u case(s) imposée(s)\n",
+           (unsigned long long)game_zdd_nb_solutions(z), game_zdd_size(z),
+           game_zdd_forced(z, forced, dirs));
+    free(forced);
+    free(dirs);
+    bool saved = (argc < 4) || game_zdd_save(z, argv[3]);
+    game_zdd_delete(z);
+    if (!saved) {
+      fprintf(stderr, "Erreur : impossible de créer %s\n", argv[3]);
+      game_delete(g);
+      return EXIT_FAILURE;
+    }
+
+  } else if (strcmp(argv[1], "-e") == 0) {
+    // Option -e : estimation du nombre de solutions à 10 % près, avec un
+    // intervalle de confiance à 95 %
+    game_estimate e = game_estimate_solutions(g, 0.1, 0.95, 0);
+    FILE *f = (argc == 4) ? fopen(argv[3], "w") : stdout;
+    if (!f) {
+      fprintf(stderr, "Erreur : impossible de créer %s\n", argv[3]);
+      game_delete(g);
+      return EXIT_FAILURE;
+    }
+    if (e.exact)
+      fprintf(f, "%.0f\n", e.estimate);
+    else
+      fprintf(f, "%.3g [%.3g, %.3g] (%llu sondes%s)\n", e.estimate, e.low,
+              e.high, (unsigned long long)e.nb_probes,
+              e.converged ? "" : ", non convergée");
+    if (f != stdout) fclose(f);
+
   } else if (strcmp(argv[1], "-c") == 0) {
-    // Option -c : compter les solutions
-    uint nb_solutions = game_nb_solutions(g);
+    // Option -c : compter les solutions, sur 64 bits
+    uint64_t nb_solutions = 0;
+    if (nb_threads == 1)
+      game_nb_solutions_opts(g, NULL, &nb_solutions);
+    else
+      nb_solutions = game_nb_solutions_parallel(g, nb_threads, split_depth);
 
     // Sauvegarder ou afficher le résultat
     if (argc == 4) {
@@ -56,11 +178,53 @@ int main(int argc, char *argv[]) {
         game_delete(g);
         return EXIT_FAILURE;
       }
-      fprintf(f, "%u\n", nb_solutions);
+      fprintf(f, "%llu\n", (unsigned long long)nb_solutions);
       fclose(f);
     } else {
-      printf("%u\n", nb_solutions);
+      printf("%llu\n", (unsigned long long)nb_solutions);
+    }
+
+  } else if (strcmp(argv[1], "-u") == 0) {
+    // Option -u : tester l'unicité de la solution (1 si unique, 0 sinon)
+    int unique = game_has_unique_solution(g) ? 1 : 0;
+    if (argc == 4) {
+      FILE *f = fopen(argv[3], "w");
+      if (!f) {
+        fprintf(stderr, "Erreur : impossible de créer %s\n", argv[3]);
+        game_delete(g);
+        return EXIT_FAILURE;
+      }
+      fprintf(f, "%d\n", unique);
+      fclose(f);
+    } else {
+      printf("%d\n", unique);
+    }
+
+  } else if (strcmp(argv[1], "-p") == 0) {
+    // Option -p : rapport du pré-traitement, sans recherche
+    FILE *f = (argc == 4) ? fopen(argv[3], "w") : stdout;
+    if (!f) {
+      fprintf(stderr, "Erreur : impossible de créer %s\n", argv[3]);
+      game_delete(g);
+      return EXIT_FAILURE;
+    }
+    bool ok = game_presolve(g, f);
+    if (f != stdout) fclose(f);
+    if (!ok) {
+      game_delete(g);
+      return EXIT_FAILURE;  // Pas de solution
+    }
+
+  } else if (strcmp(argv[1], "-d") == 0) {
+    // Option -d : exporter les clauses au format DIMACS
+    FILE *f = (argc == 4) ? fopen(argv[3], "w") : stdout;
+    if (!f) {
+      fprintf(stderr, "Erreur : impossible de créer %s\n", argv[3]);
+      game_delete(g);
+      return EXIT_FAILURE;
     }
+    game_export_dimacs(g, f);
+    if (f != stdout) fclose(f);
 
   } else {
     fprintf(stderr, "Option inconnue : %s\n", argv[1]);
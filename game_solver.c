@@ -0,0 +1,928 @@
+/**
+ * @file game_solver.c
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "game_solver.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "game.h"
+#include "game_aux.h"
+#include "game_ext.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+#define OPPOSITE(d) (((d) + 2) % NB_DIRS)
+
+/* initial number of entries of the history, which doubles when full: a
+ * search rarely goes deep, and the worst case (about 28 entries per square)
+ * would be paid again by every copy of the solver */
+#define HIST_INIT 1024
+
+/* ************************************************************************** */
+/*                             CREATE / DELETE                                */
+/* ************************************************************************** */
+
+/* keep only the orientations giving distinct codes, using the _code table,
+ * and precompute the domain tables used by the propagation */
+static void _solver_init_orients(solver* s) {
+  for (uint sh = 0; sh < NB_SHAPES; sh++) {
+    s->nb_orients[sh] = 0;
+    s->domain[sh] = 0;
+    for (uint o = 0; o < NB_DIRS; o++) {
+      bool seen = false;
+      for (uint k = 0; k < o; k++)
+        if (_code[sh][k] == _code[sh][o]) seen = true;
+      if (seen) continue;
+      s->orients[sh][s->nb_orients[sh]++] = o;
+      s->domain[sh] |= 1 << o;
+    }
+
+    for (uint dom = 0; dom < (1 << NB_DIRS); dom++) {
+      uint may = 0b0000, must = 0b1111;
+      for (uint o = 0; o < NB_DIRS; o++)
+        if (dom & (1 << o)) {
+          may |= _code[sh][o];
+          must &= _code[sh][o];
+        }
+      s->may[sh][dom] = may;
+      s->must[sh][dom] = (dom == 0) ? 0b0000 : must;
+    }
+
+    for (direction d = 0; d < NB_DIRS; d++) {
+      s->keep[sh][d][0] = s->keep[sh][d][1] = 0;
+      for (uint o = 0; o < NB_DIRS; o++) {
+        bool he = (_code[sh][o] & DIR_MASK(d)) != 0;
+        s->keep[sh][d][he] |= 1 << o;
+      }
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* allocate a solver and its arrays for a grid of the given size */
+static solver* _solver_alloc(uint nb_rows, uint nb_cols) {
+  solver* s = (solver*)malloc(sizeof(solver));
+  assert(s);
+  s->nb_rows = nb_rows;
+  s->nb_cols = nb_cols;
+  s->nb_cells = nb_rows * nb_cols;
+
+  uint n = s->nb_cells;
+  s->shapes = (unsigned char*)malloc(n * sizeof(unsigned char));
+  s->dirs = (direction*)malloc(n * sizeof(direction));
+  s->prefs = (unsigned char*)malloc(n * sizeof(unsigned char));
+  s->codes = (unsigned char*)malloc(n * sizeof(unsigned char));
+  s->adj = (uint*)malloc(NB_DIRS * n * sizeof(uint));
+  s->doms = (unsigned char*)malloc(n * sizeof(unsigned char));
+  // a domain loses at least one orientation each time it changes
+  s->trail = (uint*)malloc(NB_DIRS * n * sizeof(uint));
+  s->trail_doms = (unsigned char*)malloc(NB_DIRS * n * sizeof(unsigned char));
+  s->queue = (uint*)malloc(n * sizeof(uint));
+  s->queued = (unsigned char*)calloc(n, sizeof(unsigned char));
+  s->placed = (uint*)malloc(n * sizeof(uint));
+  s->uf_parent = (uint*)malloc(n * sizeof(uint));
+  s->uf_size = (uint*)malloc(n * sizeof(uint));
+  s->uf_open = (uint*)malloc(n * sizeof(uint));
+  s->hist_capacity = HIST_INIT;
+  s->hist_addr = (uint**)malloc(s->hist_capacity * sizeof(uint*));
+  s->hist_old = (uint*)malloc(s->hist_capacity * sizeof(uint));
+  // one frame per square, and one more for the goal of the row-major search
+  s->frames = (solver_frame*)malloc((n + 1) * sizeof(solver_frame));
+  assert(s->hist_addr && s->hist_old);
+  assert(n == 0 || (s->shapes && s->dirs && s->prefs && s->codes && s->adj &&
+                    s->doms && s->trail && s->trail_doms && s->queue &&
+                    s->queued && s->placed && s->uf_parent && s->uf_size &&
+                    s->uf_open && s->frames));
+
+  s->trail_len = 0;
+  s->queue_head = s->queue_len = 0;
+  s->hist_len = 0;
+  s->order = NULL;
+  s->nb_order = 0;
+  s->depth = 0;
+  s->nb_placed = 0;
+  s->nb_mismatch = 0;
+  s->nb_solutions = 0;
+  s->limit = UINT64_MAX;
+  s->on_solution = NULL;
+  s->on_solution_ctx = NULL;
+  s->time_limit = 0;
+  s->max_nodes = 0;
+  s->cancel = NULL;
+  s->progress = NULL;
+  s->progress_every = 0;
+  s->progress_ctx = NULL;
+  s->deadline = 0;
+  s->nb_nodes = 0;
+  s->status = SOLVER_FINISHED;
+  return s;
+}
+
+/* ************************************************************************** */
+
+solver* _solver_new(cgame g) {
+  assert(g);
+  solver* s = _solver_alloc(game_nb_rows(g), game_nb_cols(g));
+  s->wrapping = game_is_wrapping(g);
+  s->mode = SOLVER_PROPAGATE;
+  s->nb_pieces = 0;
+  s->first_piece = NO_CELL;
+  _solver_init_orients(s);
+
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++) {
+      uint c = i * s->nb_cols + j;
+      s->shapes[c] = game_get_piece_shape(g, i, j);
+      s->dirs[c] = game_get_piece_orientation(g, i, j);
+      s->codes[c] = _code[s->shapes[c]][s->dirs[c]];
+      // the distinct orientation giving the current code is tried first
+      uint sh = s->shapes[c], k = 0;
+      while (_code[sh][s->orients[sh][k]] != s->codes[c]) k++;
+      s->prefs[c] = s->orients[sh][k];
+      s->doms[c] = s->domain[s->shapes[c]];
+      if (s->shapes[c] != EMPTY && s->nb_pieces++ == 0) s->first_piece = c;
+      for (direction d = 0; d < NB_DIRS; d++) {
+        uint ni, nj;
+        bool next = game_get_ajacent_square(g, i, j, d, &ni, &nj);
+        s->adj[NB_DIRS * c + d] = next ? ni * s->nb_cols + nj : NO_CELL;
+      }
+    }
+
+  return s;
+}
+
+/* ************************************************************************** */
+
+solver* _solver_copy(const solver* s) {
+  assert(s);
+  // the trail and the history point into the arrays of the original solver
+  assert(s->trail_len == 0 && s->hist_len == 0 && s->queue_len == 0);
+  solver* t = _solver_alloc(s->nb_rows, s->nb_cols);
+  uint n = s->nb_cells;
+  t->mode = s->mode;
+  t->limit = s->limit;
+  t->wrapping = s->wrapping;
+  t->nb_pieces = s->nb_pieces;
+  t->first_piece = s->first_piece;
+  t->nb_placed = s->nb_placed;
+  t->nb_mismatch = s->nb_mismatch;
+  _solver_init_orients(t);
+  memcpy(t->shapes, s->shapes, n * sizeof(unsigned char));
+  memcpy(t->dirs, s->dirs, n * sizeof(direction));
+  memcpy(t->prefs, s->prefs, n * sizeof(unsigned char));
+  memcpy(t->codes, s->codes, n * sizeof(unsigned char));
+  memcpy(t->adj, s->adj, NB_DIRS * n * sizeof(uint));
+  memcpy(t->doms, s->doms, n * sizeof(unsigned char));
+  memcpy(t->placed, s->placed, n * sizeof(uint));
+  memcpy(t->uf_parent, s->uf_parent, n * sizeof(uint));
+  memcpy(t->uf_size, s->uf_size, n * sizeof(uint));
+  memcpy(t->uf_open, s->uf_open, n * sizeof(uint));
+  if (s->order) {
+    t->order = (uint*)malloc(n * sizeof(uint));
+    assert(t->order);
+    memcpy(t->order, s->order, n * sizeof(uint));
+    t->nb_order = s->nb_order;
+  }
+  return t;
+}
+
+/* ************************************************************************** */
+
+void _solver_delete(solver* s) {
+  if (!s) return;
+  free(s->shapes);
+  free(s->dirs);
+  free(s->prefs);
+  free(s->codes);
+  free(s->adj);
+  free(s->doms);
+  free(s->trail);
+  free(s->trail_doms);
+  free(s->queue);
+  free(s->queued);
+  free(s->placed);
+  free(s->uf_parent);
+  free(s->uf_size);
+  free(s->uf_open);
+  free(s->hist_addr);
+  free(s->hist_old);
+  free(s->frames);
+  free(s->order);
+  free(s);
+}
+
+/* ************************************************************************** */
+/*                                 CHECKS                                     */
+/* ************************************************************************** */
+
+/* check square c with the given code against the grid border and against
+ * all its neighbours: those before c in row-major order are assigned, which
+ * includes the wrap-around edges of the last row and column towards row 0
+ * and column 0; the others are only known by their shape (an EMPTY square
+ * has no half-edge, a CROSS square has all of them) */
+static bool _solver_fits(const solver* s, uint c, uint code) {
+  const uint* adj = &s->adj[NB_DIRS * c];
+  for (direction d = 0; d < NB_DIRS; d++) {
+    bool he = (code & DIR_MASK(d)) != 0;
+    uint next = adj[d];
+    bool next_he;
+    if (next == NO_CELL)
+      next_he = false;
+    else if (next == c)
+      next_he = (code & DIR_MASK(OPPOSITE(d))) != 0;
+    else if (next < c)
+      next_he = (s->codes[next] & DIR_MASK(OPPOSITE(d))) != 0;
+    else if (s->shapes[next] == EMPTY || s->shapes[next] == CROSS)
+      next_he = (s->shapes[next] == CROSS);
+    else
+      continue;
+    if (he != next_he) return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+/*                               CONNECTIVITY                                 */
+/* ************************************************************************** */
+
+/* The squares whose orientation is fixed are grouped in components by a
+ * union-find of their matched edges. Each component counts its open
+ * half-edges, i.e. those leading to a square which is not fixed yet (or
+ * mismatched). A component without open half-edges can no longer grow, so
+ * if it does not hold all the pieces, the game cannot be connected. There
+ * is no path compression: every change is saved in the history instead, so
+ * that it can be undone on backtrack. */
+
+/* double the capacity of the history */
+static void _solver_hist_grow(solver* s) {
+  s->hist_capacity *= 2;
+  s->hist_addr =
+      (uint**)realloc(s->hist_addr, s->hist_capacity * sizeof(uint*));
+  s->hist_old = (uint*)realloc(s->hist_old, s->hist_capacity * sizeof(uint));
+  assert(s->hist_addr && s->hist_old);
+}
+
+/* ************************************************************************** */
+
+static void _solver_hist_set(solver* s, uint* addr, uint value) {
+  if (s->hist_len == s->hist_capacity) _solver_hist_grow(s);
+  s->hist_addr[s->hist_len] = addr;
+  s->hist_old[s->hist_len] = *addr;
+  s->hist_len++;
+  *addr = value;
+}
+
+/* ************************************************************************** */
+
+static uint _solver_find(const solver* s, uint c) {
+  while (s->uf_parent[c] != c) c = s->uf_parent[c];
+  return c;
+}
+
+/* ************************************************************************** */
+
+static void _solver_init_uf(solver* s) {
+  s->hist_len = 0;
+  s->nb_placed = 0;
+  s->nb_mismatch = 0;
+  for (uint c = 0; c < s->nb_cells; c++) {
+    s->placed[c] = (s->shapes[c] == EMPTY);
+    s->uf_parent[c] = c;
+    s->uf_size[c] = (s->shapes[c] == EMPTY) ? 0 : 1;
+    s->uf_open[c] = 0;
+  }
+}
+
+/* ************************************************************************** */
+
+/* fix square c with its current code, and update the number of mismatched
+ * half-edges between fixed squares, returns false if this closes a component
+ * while other pieces remain */
+static bool _solver_place(solver* s, uint c) {
+  uint code = s->codes[c];
+  uint open = 0, mismatch = 0;
+  _solver_hist_set(s, &s->placed[c], true);
+  _solver_hist_set(s, &s->nb_placed, s->nb_placed + 1);
+
+  for (direction d = 0; d < NB_DIRS; d++) {
+    bool he = (code & DIR_MASK(d)) != 0;
+    uint next = s->adj[NB_DIRS * c + d];
+    if (next == NO_CELL || next == c) {
+      // out of grid or wrapping onto itself (single row or column)
+      if (he && (next == NO_CELL || !(code & DIR_MASK(OPPOSITE(d))))) {
+        open++;
+        mismatch++;
+      }
+      continue;
+    }
+    if (!s->placed[next]) {
+      if (he) open++;
+      continue;
+    }
+    bool next_he = (s->codes[next] & DIR_MASK(OPPOSITE(d))) != 0;
+    if (he != next_he) {
+      if (he) open++;  // a mismatched half-edge is never closed
+      mismatch++;
+      continue;
+    }
+    if (!he) continue;
+
+    // matched edge: merge the two components
+    uint rc = _solver_find(s, c);
+    uint rn = _solver_find(s, next);
+    _solver_hist_set(s, &s->uf_open[rn], s->uf_open[rn] - 1);
+    if (rc == rn) continue;
+    if (s->uf_size[rc] > s->uf_size[rn]) {
+      uint tmp = rc;
+      rc = rn;
+      rn = tmp;
+    }
+    _solver_hist_set(s, &s->uf_parent[rc], rn);
+    _solver_hist_set(s, &s->uf_size[rn], s->uf_size[rn] + s->uf_size[rc]);
+    _solver_hist_set(s, &s->uf_open[rn], s->uf_open[rn] + s->uf_open[rc]);
+  }
+
+  if (mismatch > 0)
+    _solver_hist_set(s, &s->nb_mismatch, s->nb_mismatch + mismatch);
+  uint r = _solver_find(s, c);
+  _solver_hist_set(s, &s->uf_open[r], s->uf_open[r] + open);
+  return s->uf_open[r] > 0 || s->uf_size[r] == s->nb_pieces;
+}
+
+/* ************************************************************************** */
+
+/* goal test, in place of game_won(): all the pieces are fixed, without any
+ * mismatch, and only then, they all belong to the same component */
+static bool _solver_goal(const solver* s) {
+  if (s->nb_placed < s->nb_pieces || s->nb_mismatch > 0) return false;
+  if (s->nb_pieces == 0) return true;
+  return s->uf_size[_solver_find(s, s->first_piece)] == s->nb_pieces;
+}
+
+/* ************************************************************************** */
+
+/* undo the union-find changes made since the history had length mark */
+static void _solver_undo_uf(solver* s, uint mark) {
+  while (s->hist_len > mark) {
+    s->hist_len--;
+    *s->hist_addr[s->hist_len] = s->hist_old[s->hist_len];
+  }
+}
+
+/* ************************************************************************** */
+/*                               PROPAGATION                                  */
+/* ************************************************************************** */
+
+static void _solver_push(solver* s, uint c) {
+  if (s->queued[c]) return;
+  s->queued[c] = true;
+  s->queue[(s->queue_head + s->queue_len++) % s->nb_cells] = c;
+}
+
+/* ************************************************************************** */
+
+static uint _solver_pop(solver* s) {
+  uint c = s->queue[s->queue_head];
+  s->queue_head = (s->queue_head + 1) % s->nb_cells;
+  s->queue_len--;
+  s->queued[c] = false;
+  return c;
+}
+
+/* ************************************************************************** */
+
+static void _solver_clear_queue(solver* s) {
+  while (s->queue_len > 0) _solver_pop(s);
+}
+
+/* ************************************************************************** */
+
+/* fix the orientation of square c when its domain is a singleton */
+static bool _solver_place_dom(solver* s, uint c) {
+  uint o = 0;
+  while (!(s->doms[c] & (1 << o))) o++;
+  s->dirs[c] = o;
+  s->codes[c] = _code[s->shapes[c]][o];
+  return _solver_place(s, c);
+}
+
+/* ************************************************************************** */
+
+/* change the domain of square c, saving the old one in the trail, returns
+ * false if fixing the square makes the game disconnected */
+static bool _solver_set_dom(solver* s, uint c, uint dom) {
+  s->trail[s->trail_len] = c;
+  s->trail_doms[s->trail_len] = s->doms[c];
+  s->trail_len++;
+  s->doms[c] = dom;
+  _solver_push(s, c);
+  if (dom & (dom - 1)) return true;
+  return _solver_place_dom(s, c);
+}
+
+/* ************************************************************************** */
+
+/* restore all the domains changed since the trail had length mark, and the
+ * union-find since the history had length hist */
+static void _solver_undo(solver* s, uint mark, uint hist) {
+  while (s->trail_len > mark) {
+    s->trail_len--;
+    s->doms[s->trail[s->trail_len]] = s->trail_doms[s->trail_len];
+  }
+  _solver_undo_uf(s, hist);
+}
+
+/* ************************************************************************** */
+
+/* keep only the orientations of square c with (or without) a half-edge in
+ * direction d, returns false if the domain becomes empty */
+static bool _solver_restrict(solver* s, uint c, direction d, bool he) {
+  uint dom = s->doms[c] & s->keep[s->shapes[c]][d][he];
+  if (dom == s->doms[c]) return true;
+  if (dom == 0) return false;
+  return _solver_set_dom(s, c, dom);
+}
+
+/* ************************************************************************** */
+
+/* arc-consistency: a half-edge that square c must have (or cannot have) is
+ * forced (or forbidden) on the other side of the edge */
+static bool _solver_propagate(solver* s) {
+  while (s->queue_len > 0) {
+    uint c = _solver_pop(s);
+    uint sh = s->shapes[c];
+    uint may = s->may[sh][s->doms[c]];
+    uint must = s->must[sh][s->doms[c]];
+    for (direction d = 0; d < NB_DIRS; d++) {
+      uint next = s->adj[NB_DIRS * c + d];
+      if (next == NO_CELL) continue;  // already handled by _solver_init_doms
+      bool ok = true;
+      if (!(may & DIR_MASK(d)))
+        ok = _solver_restrict(s, next, OPPOSITE(d), false);
+      else if (must & DIR_MASK(d))
+        ok = _solver_restrict(s, next, OPPOSITE(d), true);
+      if (!ok) {
+        _solver_clear_queue(s);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* orientations of square c allowed by the grid border and by the neighbours
+ * whose code is known from their shape alone (EMPTY and CROSS); besides, two
+ * ENDPOINTs never face each other, unless they are the only pieces */
+static uint _solver_local_dom(const solver* s, uint c) {
+  uint sh = s->shapes[c], dom = s->domain[sh];
+  for (direction d = 0; d < NB_DIRS; d++) {
+    uint next = s->adj[NB_DIRS * c + d];
+    if (next == c) continue;  // wrapping onto itself
+    uint next_sh = (next == NO_CELL) ? EMPTY : s->shapes[next];
+    if (next_sh == EMPTY ||
+        (sh == ENDPOINT && next_sh == ENDPOINT && s->nb_pieces > 2))
+      dom &= s->keep[sh][d][false];
+    else if (next_sh == CROSS)
+      dom &= s->keep[sh][d][true];
+  }
+  return dom;
+}
+
+/* ************************************************************************** */
+
+/* initial domains: those allowed by the neighbours, then propagate */
+static bool _solver_init_doms(solver* s) {
+  s->trail_len = 0;
+  for (uint c = 0; c < s->nb_cells; c++) {
+    s->doms[c] = _solver_local_dom(s, c);
+    if (s->doms[c] == 0) return false;
+  }
+  for (uint c = 0; c < s->nb_cells; c++) _solver_push(s, c);
+  bool ok = true;
+  for (uint c = 0; c < s->nb_cells && ok; c++)
+    if (!s->placed[c] && (s->doms[c] & (s->doms[c] - 1)) == 0)
+      ok = _solver_place_dom(s, c);
+  ok = ok && _solver_propagate(s);
+  _solver_clear_queue(s);
+  // the root domains and components are never undone
+  s->trail_len = 0;
+  s->hist_len = 0;
+  return ok;
+}
+
+/* ************************************************************************** */
+/*                                 PRESOLVE                                   */
+/* ************************************************************************** */
+
+/* number of half-edges of each shape */
+static const uint _degree[NB_SHAPES] = {0, 1, 2, 2, 3, 4};
+
+/* number of orientations in a domain */
+static uint _dom_size(uint dom) {
+  return (dom & 1) + ((dom >> 1) & 1) + ((dom >> 2) & 1) + (dom >> 3);
+}
+
+/* ************************************************************************** */
+
+/* number of pieces reachable from the first one through non-empty squares */
+static uint _solver_reachable(solver* s) {
+  if (s->nb_pieces == 0) return 0;
+  // the propagation queue is empty here, it is used as a plain array
+  uint len = 0;
+  s->queue[len++] = s->first_piece;
+  s->queued[s->first_piece] = true;
+  for (uint k = 0; k < len; k++)
+    for (direction d = 0; d < NB_DIRS; d++) {
+      uint next = s->adj[NB_DIRS * s->queue[k] + d];
+      if (next == NO_CELL || s->shapes[next] == EMPTY || s->queued[next])
+        continue;
+      s->queued[next] = true;
+      s->queue[len++] = next;
+    }
+  for (uint k = 0; k < len; k++) s->queued[s->queue[k]] = false;
+  return len;
+}
+
+/* ************************************************************************** */
+
+/* are all the pieces next to square c ENDPOINTs? */
+static bool _solver_endpoints_only(const solver* s, uint c) {
+  for (direction d = 0; d < NB_DIRS; d++) {
+    uint next = s->adj[NB_DIRS * c + d];
+    if (next != NO_CELL && next != c && s->shapes[next] != EMPTY &&
+        s->shapes[next] != ENDPOINT)
+      return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+bool _solver_presolve(solver* s, presolve_report* r) {
+  assert(s && r && s->queue_len == 0);
+  r->status = PRESOLVE_OK;
+  r->nb_pieces = s->nb_pieces;
+  r->nb_half_edges = 0;
+  r->nb_fixed = 0;
+  r->nb_removed = 0;
+  for (uint c = 0; c < s->nb_cells; c++)
+    r->nb_half_edges += _degree[s->shapes[c]];
+
+  // necessary conditions: every half-edge is matched by another one, and a
+  // connected game needs at least nb_pieces-1 edges
+  if (r->nb_half_edges % 2 != 0)
+    r->status = PRESOLVE_ODD_HALF_EDGES;
+  else if (s->nb_pieces > 0 && r->nb_half_edges / 2 < s->nb_pieces - 1)
+    r->status = PRESOLVE_FEW_EDGES;
+  else if (_solver_reachable(s) < s->nb_pieces)
+    r->status = PRESOLVE_ISLAND;
+  if (r->status != PRESOLVE_OK) return false;
+
+  // reduced problem: the domains allowed by the neighbours of each square
+  s->trail_len = 0;
+  for (uint c = 0; c < s->nb_cells; c++) {
+    uint sh = s->shapes[c];
+    s->doms[c] = _solver_local_dom(s, c);
+    if (s->doms[c] == 0) {
+      r->status = (sh == ENDPOINT && _solver_endpoints_only(s, c))
+                      ? PRESOLVE_ISLAND
+                      : PRESOLVE_NO_ORIENTATION;
+      return false;
+    }
+    r->nb_removed += _dom_size(s->domain[sh]) - _dom_size(s->doms[c]);
+    if (sh != EMPTY && _dom_size(s->doms[c]) == 1) r->nb_fixed++;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+/*                                 SEARCH                                     */
+/* ************************************************************************** */
+
+/* number of nodes between two reads of the clock */
+#define CLOCK_PERIOD 1024
+
+/* monotonic time, in seconds */
+static double _solver_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* ************************************************************************** */
+
+/* count a new node at the given depth and check the limits of the search,
+ * returns true (with the reason in status) to stop it */
+static bool _solver_interrupted(solver* s, uint depth) {
+  s->nb_nodes++;
+  if (s->progress && s->progress_every > 0 &&
+      s->nb_nodes % s->progress_every == 0)
+    s->progress(s->nb_nodes, depth, s->progress_ctx);
+  if (s->cancel && *s->cancel)
+    s->status = SOLVER_CANCELLED;
+  else if (s->max_nodes > 0 && s->nb_nodes > s->max_nodes)
+    s->status = SOLVER_NODE_LIMIT;
+  else if (s->deadline > 0 && s->nb_nodes % CLOCK_PERIOD == 0 &&
+           _solver_now() >= s->deadline)
+    s->status = SOLVER_TIMEOUT;
+  return s->status != SOLVER_FINISHED;
+}
+
+/* ************************************************************************** */
+
+/* record the solution found, returns true to stop the search */
+static bool _solver_found(solver* s) {
+  s->nb_solutions++;
+  if (s->on_solution && !s->on_solution(s->dirs, s->on_solution_ctx))
+    return true;
+  return s->nb_solutions >= s->limit;
+}
+
+/* ************************************************************************** */
+
+/* row-major depth-first search, returns true to stop the search; frame c
+ * holds the next orientation of square c to try */
+static bool _solver_search(solver* s) {
+  uint c = 0;
+  s->frames[0].next = 0;
+  s->frames[0].hist = s->hist_len;
+  while (true) {
+    if (c == s->nb_cells) {
+      if (_solver_goal(s) && _solver_found(s)) return true;
+      if (c-- == 0) return false;
+      continue;
+    }
+
+    solver_frame* f = &s->frames[c];
+    _solver_undo_uf(s, f->hist);
+    uint sh = s->shapes[c];
+    bool placed = false;
+    while (!placed && f->next < s->nb_orients[sh]) {
+      uint o = s->orients[sh][f->next++];
+      uint code = _code[sh][o];
+      if (!_solver_fits(s, c, code)) continue;
+      if (_solver_interrupted(s, c)) return true;
+      s->dirs[c] = o;
+      s->codes[c] = code;
+      placed = (sh == EMPTY) || _solver_place(s, c);
+      if (!placed) _solver_undo_uf(s, f->hist);
+    }
+    if (placed) {
+      c++;
+      s->frames[c].next = 0;
+      s->frames[c].hist = s->hist_len;
+    } else if (c-- == 0)
+      return false;
+  }
+}
+
+/* ************************************************************************** */
+
+/* push a decision on square c, or test the goal if c is NO_CELL, returns
+ * true to stop the search */
+static bool _solver_push_frame(solver* s, uint c) {
+  if (c == NO_CELL) return _solver_goal(s) && _solver_found(s);
+  solver_frame* f = &s->frames[s->depth++];
+  f->cell = c;
+  f->next = 0;
+  f->trail = s->trail_len;
+  f->hist = s->hist_len;
+  return false;
+}
+
+/* ************************************************************************** */
+
+/* go on with the search with propagation from the decisions on the stack,
+ * returns true to stop the search (the solution is then left in the solver,
+ * otherwise it is back to where it started); a search stopped by a limit
+ * resumes exactly where it was */
+static bool _solver_continue_ac(solver* s) {
+  while (s->depth > 0) {
+    solver_frame* f = &s->frames[s->depth - 1];
+    _solver_undo(s, f->trail, f->hist);
+    uint c = f->cell, dom = s->doms[c], pref = s->prefs[c], o = NB_DIRS;
+    while (o == NB_DIRS && f->next < NB_DIRS) {
+      uint k = f->next++;
+      uint next = (k == 0) ? pref : (k <= pref) ? k - 1 : k;
+      if (dom & (1 << next)) o = next;
+    }
+    if (o == NB_DIRS) {
+      s->depth--;
+      continue;
+    }
+    if (_solver_interrupted(s, s->depth)) {
+      // o is the first node of the search once it resumes
+      f->next--;
+      s->nb_nodes--;
+      return true;
+    }
+    if (!_solver_set_dom(s, c, 1 << o) || !_solver_propagate(s)) {
+      _solver_clear_queue(s);
+      continue;
+    }
+    if (_solver_push_frame(s, _solver_next_cell(s))) return true;
+  }
+  return false;
+}
+
+/* ************************************************************************** */
+
+/* search with propagation: branch on the most constrained square, trying its
+ * current orientation first, returns true to stop the search */
+static bool _solver_search_ac(solver* s) {
+  s->depth = 0;
+  return _solver_push_frame(s, _solver_next_cell(s)) || _solver_continue_ac(s);
+}
+
+/* ************************************************************************** */
+
+bool _solver_init(solver* s) {
+  assert(s);
+  s->nb_solutions = 0;
+  _solver_init_uf(s);
+  return _solver_init_doms(s);
+}
+
+/* ************************************************************************** */
+
+/* search until limit solutions are found, returns true if it stopped there */
+static bool _solver_run(solver* s, uint64_t limit) {
+  s->limit = limit;
+  s->nb_nodes = 0;
+  s->status = SOLVER_FINISHED;
+  s->deadline = (s->time_limit > 0) ? _solver_now() + s->time_limit : 0;
+  if (s->mode == SOLVER_SAT && limit == 1) return _solver_solve_sat(s);
+  // the small grids fit in a few words, unless the search has to be stopped
+  // or followed on the way
+  if (s->mode == SOLVER_PROPAGATE && _solver_bitboard_fits(s) &&
+      !s->on_solution && !s->progress && !s->cancel && s->max_nodes == 0 &&
+      s->time_limit == 0)
+    return _solver_count_bitboard(s, limit) >= limit;
+  if (s->mode != SOLVER_BACKTRACK)
+    return _solver_init(s) && _solver_search_ac(s);
+  s->nb_solutions = 0;
+  _solver_init_uf(s);
+  return _solver_search(s);
+}
+
+/* ************************************************************************** */
+
+solver_mark _solver_mark(const solver* s) {
+  solver_mark m = {s->trail_len, s->hist_len};
+  return m;
+}
+
+/* ************************************************************************** */
+
+bool _solver_decide(solver* s, uint c, uint o) {
+  assert(c < s->nb_cells && (s->doms[c] & (1 << o)));
+  if (_solver_set_dom(s, c, 1 << o) && _solver_propagate(s)) return true;
+  _solver_clear_queue(s);
+  return false;
+}
+
+/* ************************************************************************** */
+
+bool _solver_narrow(solver* s, uint c, uint dom) {
+  assert(c < s->nb_cells);
+  dom &= s->doms[c];
+  if (dom == s->doms[c]) return true;
+  if (dom != 0 && _solver_set_dom(s, c, dom) && _solver_propagate(s))
+    return true;
+  _solver_clear_queue(s);
+  return false;
+}
+
+/* ************************************************************************** */
+
+void _solver_restore(solver* s, solver_mark m) {
+  _solver_undo(s, m.trail, m.hist);
+}
+
+/* ************************************************************************** */
+
+uint _solver_next_cell(const solver* s) {
+  if (s->nb_placed == s->nb_pieces) return NO_CELL;
+  uint best = NO_CELL, best_size = NB_DIRS + 1, best_fixed = 0;
+  uint len = s->order ? s->nb_order : s->nb_cells;
+  for (uint k = 0; k < len; k++) {
+    uint c = s->order ? s->order[k] : k;
+    if (s->placed[c]) continue;
+    uint size = _dom_size(s->doms[c]);
+    if (size > best_size) continue;
+    // ties: the most fixed neighbours (the grid border counts as fixed)
+    uint fixed = 0;
+    for (direction d = 0; d < NB_DIRS; d++) {
+      uint next = s->adj[NB_DIRS * c + d];
+      if (next == NO_CELL || s->placed[next]) fixed++;
+    }
+    if (size == best_size && fixed <= best_fixed) continue;
+    best = c;
+    best_size = size;
+    best_fixed = fixed;
+    // singletons are always placed, nothing can beat this one
+    if (size == 2 && fixed == NB_DIRS) break;
+  }
+  return best;
+}
+
+/* ************************************************************************** */
+
+void _solver_set_seed(solver* s, uint seed) {
+  assert(s);
+  uint n = s->nb_cells, x = seed ? seed : 1;
+  if (!s->order) s->order = (uint*)malloc(n * sizeof(uint));
+  assert(n == 0 || s->order);
+  for (uint c = 0; c < n; c++) s->order[c] = c;
+  s->nb_order = n;
+  for (uint c = 0; c < n; c++) {
+    // xorshift32
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    uint sh = s->shapes[c], k = c + x % (n - c), tmp = s->order[c];
+    s->order[c] = s->order[k];
+    s->order[k] = tmp;
+    s->prefs[c] = s->orients[sh][(x >> 8) % s->nb_orients[sh]];
+  }
+}
+
+/* ************************************************************************** */
+
+uint64_t _solver_count_subtree(solver* s) {
+  assert(s);
+  s->nb_solutions = 0;
+  _solver_search_ac(s);
+  return s->nb_solutions;
+}
+
+/* ************************************************************************** */
+
+bool _solver_solve(solver* s) {
+  assert(s);
+  _solver_run(s, 1);
+  return s->status == SOLVER_FINISHED && s->nb_solutions > 0;
+}
+
+/* ************************************************************************** */
+
+uint64_t _solver_count(solver* s, uint64_t limit) {
+  assert(s && limit > 0);
+  _solver_run(s, limit);
+  return s->nb_solutions;
+}
+
+/* ************************************************************************** */
+
+bool _solver_start(solver* s) {
+  assert(s);
+  s->limit = 1;
+  s->nb_nodes = 0;
+  s->status = SOLVER_FINISHED;
+  s->deadline = 0;
+  s->depth = 0;
+  presolve_report report;
+  if (!_solver_presolve(s, &report) || !_solver_init(s)) return false;
+  _solver_push_frame(s, _solver_next_cell(s));
+  return true;
+}
+
+/* ************************************************************************** */
+
+bool _solver_resume(solver* s) {
+  assert(s);
+  if (s->nb_solutions > 0) return true;
+  s->status = SOLVER_FINISHED;
+  s->deadline = (s->time_limit > 0) ? _solver_now() + s->time_limit : 0;
+  return _solver_continue_ac(s);
+}
+
+/* ************************************************************************** */
+
+void _solver_apply(const solver* s, game g) {
+  assert(s && g);
+  assert(s->nb_rows == game_nb_rows(g) && s->nb_cols == game_nb_cols(g));
+  for (uint i = 0; i < s->nb_rows; i++)
+    for (uint j = 0; j < s->nb_cols; j++) {
+      uint c = i * s->nb_cols + j;
+      // keep the current orientation if it already gives the right code
+      direction o = game_get_piece_orientation(g, i, j);
+      if (_code[s->shapes[c]][o] != s->codes[c])
+        game_set_piece_orientation(g, i, j, s->dirs[c]);
+    }
+}
+
+/* ************************************************************************** */
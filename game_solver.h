@@ -0,0 +1,433 @@
+/**
+ * @file game_solver.h
+ * @brief Private Solver Engine.
+ * @details The engine works on its own copy of the grid, where each piece is
+ * stored as a 4-bit half-edge code (see the _code table in game_tools.h). The
+ * game itself is only read when the engine is created and only written once,
+ * when a solution is copied back with @ref _solver_apply.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#ifndef __GAME_SOLVER_H__
+#define __GAME_SOLVER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "game.h"
+
+/* ************************************************************************** */
+/*                                MACRO                                       */
+/* ************************************************************************** */
+
+/** no adjacent square (out of grid) */
+#define NO_CELL ((uint)-1)
+
+/** mask of the half-edge in direction d, using the bit layout of _code */
+#define DIR_MASK(d) (0b1000 >> (d))
+
+/** number of decisions after which the parallel search splits into tasks */
+#define SOLVER_SPLIT_DEPTH 10
+
+/** largest shorter side counted by the frontier sweep, without wrapping
+ * (w+1 slots of 4 bits in a 64-bit state) */
+#define FRONTIER_MAX_WIDTH 14
+
+/** largest shorter side counted by the frontier sweep, with wrapping
+ * (2w+2 slots of 4 bits in a 64-bit state) */
+#define FRONTIER_MAX_WIDTH_WRAP 6
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** search modes of the solver */
+typedef enum {
+  SOLVER_BACKTRACK, /**< plain row-major backtracking */
+  SOLVER_PROPAGATE, /**< orientation domains with arc-consistency */
+  SOLVER_SAT,       /**< CDCL on a CNF encoding (search only, counting
+                         uses SOLVER_PROPAGATE) */
+} solver_mode;
+
+/** a decision of the search, kept on a heap-allocated stack so that the
+ * depth of the search never uses the call stack */
+typedef struct {
+  uint cell;  /**< square branched on */
+  uint next;  /**< next orientation to try, in the order of the search */
+  uint trail; /**< length of the domain trail before the decision */
+  uint hist;  /**< length of the union-find history before the decision */
+} solver_frame;
+
+/** why a search stopped */
+typedef enum {
+  SOLVER_FINISHED,   /**< the search went through (or found what it needed) */
+  SOLVER_TIMEOUT,    /**< the time limit was reached */
+  SOLVER_NODE_LIMIT, /**< the node budget was used up */
+  SOLVER_CANCELLED,  /**< the cancel flag was set */
+} solver_status;
+
+/** called every progress_every nodes with the number of nodes so far and the
+ * current depth of the search */
+typedef void (*solver_progress)(uint64_t nb_nodes, uint depth, void* ctx);
+
+/** called on each solution with the orientation of every square, returns
+ * false to stop the search */
+typedef bool (*solver_callback)(const direction* dirs, void* ctx);
+
+/**
+ * @brief Solver structure.
+ * @details Squares are numbered in row-major order. Only the orientations
+ * that lead to distinct codes are explored (1 for EMPTY and CROSS, 2 for
+ * SEGMENT, 4 otherwise), so two solutions always differ by at least one
+ * visible piece.
+ */
+struct solver_s {
+  solver_mode mode;           /**< search mode (SOLVER_PROPAGATE by default) */
+  uint nb_rows;               /**< number of rows */
+  uint nb_cols;               /**< number of columns */
+  uint nb_cells;              /**< number of squares */
+  uint nb_pieces;             /**< number of non-empty squares */
+  uint first_piece;           /**< first non-empty square (or NO_CELL) */
+  bool wrapping;              /**< the wrapping option */
+  unsigned char* shapes;      /**< piece shape of each square */
+  direction* dirs;            /**< current orientation of each square */
+  unsigned char* prefs;       /**< orientation to try first (the one of the
+                                   game, up to symmetry) */
+  unsigned char* codes;       /**< current half-edge code of each square */
+  uint* adj;                  /**< adj[4*c+d]: square next to c in dir d */
+  unsigned char* doms;        /**< remaining orientations of each square */
+  uint* trail;                /**< changed squares, to undo domain changes */
+  unsigned char* trail_doms;  /**< their domains before the change */
+  uint trail_len;             /**< number of entries in the trail */
+  uint* queue;                /**< squares waiting for propagation */
+  unsigned char* queued;      /**< is the square in the queue? */
+  uint queue_head;            /**< first square of the circular queue */
+  uint queue_len;             /**< number of squares in the queue */
+  uint* placed;               /**< is the orientation of the square fixed? */
+  uint* uf_parent;            /**< union-find of the matched edges */
+  uint* uf_size;              /**< number of pieces in a component */
+  uint* uf_open;              /**< open half-edges of a component */
+  uint** hist_addr;           /**< changed union-find entries, to undo them */
+  uint* hist_old;             /**< their values before the change */
+  uint hist_len;              /**< number of entries in the history */
+  uint hist_capacity;         /**< entries allocated for the history */
+  uint* order;                /**< order in which ties between squares are
+                                   broken (NULL: row-major) */
+  uint nb_order;              /**< squares of order scanned when branching,
+                                   those after them being all fixed */
+  solver_frame* frames;       /**< stack of the decisions of the search */
+  uint depth;                 /**< number of decisions on the stack */
+  uint nb_placed;             /**< number of pieces fixed so far */
+  uint nb_mismatch;           /**< mismatched half-edges between them */
+  uint64_t nb_solutions;      /**< number of solutions found so far */
+  uint64_t limit;             /**< the search stops after this many */
+  solver_callback on_solution; /**< called on each solution (or NULL) */
+  void* on_solution_ctx;      /**< context passed to on_solution */
+  double time_limit;          /**< seconds before the search stops (or 0) */
+  uint64_t max_nodes;         /**< nodes before the search stops (or 0) */
+  volatile bool* cancel;      /**< the search stops once it is set (or NULL) */
+  solver_progress progress;   /**< called every progress_every nodes */
+  uint64_t progress_every;    /**< period of progress (0 to disable it) */
+  void* progress_ctx;         /**< context passed to progress */
+  double deadline;            /**< monotonic time to stop at (or 0) */
+  uint64_t nb_nodes;          /**< nodes of the last search */
+  solver_status status;       /**< why the last search stopped */
+  unsigned char nb_orients[NB_SHAPES];           /**< distinct orientations */
+  unsigned char orients[NB_SHAPES][NB_DIRS];     /**< list of them */
+  unsigned char domain[NB_SHAPES];               /**< bitset of them */
+  unsigned char may[NB_SHAPES][1 << NB_DIRS];    /**< OR of codes in a dom */
+  unsigned char must[NB_SHAPES][1 << NB_DIRS];   /**< AND of codes in a dom */
+  unsigned char keep[NB_SHAPES][NB_DIRS][2];     /**< orientations without (0)
+                                                      or with (1) a half-edge */
+};
+
+typedef struct solver_s solver;
+
+/** outcome of the presolve */
+typedef enum {
+  PRESOLVE_OK,             /**< no reason found to reject the game */
+  PRESOLVE_ODD_HALF_EDGES, /**< odd number of half-edges */
+  PRESOLVE_FEW_EDGES,      /**< fewer edges than pieces - 1 */
+  PRESOLVE_ISLAND,         /**< pieces that cannot reach the others (through
+                                empty squares or only ENDPOINTs) */
+  PRESOLVE_NO_ORIENTATION, /**< a square without any possible orientation */
+} presolve_status;
+
+/** report of the presolve */
+typedef struct {
+  presolve_status status; /**< why the game was rejected, if it was */
+  uint nb_pieces;         /**< number of non-empty squares */
+  uint nb_half_edges;     /**< total number of half-edges */
+  uint nb_fixed;          /**< pieces left with a single orientation */
+  uint nb_removed;        /**< orientations ruled out */
+} presolve_report;
+
+/** solver state kept with a game between two solves, updated by each move
+ * (see game_solver_warm.c) */
+typedef struct solver_warm_s {
+  solver* s;            /**< the solver, left at the root of its search */
+  bool searched;        /**< is it known whether the game has a solution? */
+  bool solved;          /**< has the game a solution (in sol)? */
+  direction* sol;       /**< orientations of the solution found */
+  signed char* forced;  /**< probing: 1 if a single orientation is left, 0 if
+                             several are, -1 if not probed yet */
+  unsigned char* cur;   /**< half-edge code of each square in the game */
+  uint nb_mismatch;     /**< unmatched half-edges of the game */
+  uint* wrong;          /**< squares whose code differs from the solution */
+  uint* wrong_pos;      /**< index of each square in wrong (or NO_CELL) */
+  uint nb_wrong;        /**< number of wrong squares */
+} solver_warm;
+
+/** reduced decision diagram of all the solutions of a grid, one level per
+ * square in the order of the frontier sweep: a node has a child per
+ * distinct orientation of its square, node 0 being the false terminal and
+ * node 1 the true one (see game_solver_zdd.c) */
+typedef struct {
+  uint nb_rows;          /**< number of rows of the grid */
+  uint nb_cols;          /**< number of columns of the grid */
+  bool wrapping;         /**< the wrapping option */
+  unsigned char* shapes; /**< shape of each square */
+  uint* cells;           /**< square of each level */
+  uint* level_start;     /**< first node of each level (nb_cells + 1 entries),
+                              the nodes being sorted by level */
+  uint nb_nodes;         /**< number of nodes, terminals included */
+  uint capacity;         /**< number of nodes allocated */
+  uint root;             /**< the root (0 if there is no solution) */
+  uint* child;           /**< NB_DIRS children per node, by orientation (0 for
+                              an orientation that is not distinct or leads to
+                              no solution) */
+  uint64_t* count;       /**< number of solutions below each node */
+  double* below;         /**< the same, as a floating-point number */
+  double* above;         /**< number of paths from the root to each node */
+} solver_zdd;
+
+/** estimate of the number of solutions (see game_solver_estimate.c) */
+typedef struct {
+  double estimate;    /**< mean of the probes */
+  double low;         /**< lower bound of the confidence interval */
+  double high;        /**< upper bound of the confidence interval */
+  uint64_t nb_probes; /**< number of probes drawn */
+  bool exact;         /**< is the estimate the exact number? */
+  bool converged;     /**< did the interval reach the relative error asked
+                           (false if the budget ran out first)? */
+} solver_estimate;
+
+/** position in the trail and in the history, to backtrack to */
+typedef struct {
+  uint trail; /**< length of the domain trail */
+  uint hist;  /**< length of the union-find history */
+} solver_mark;
+
+/* ************************************************************************** */
+/*                             SOLVER ROUTINES                                */
+/* ************************************************************************** */
+
+/** create a solver working on a private copy of game g */
+solver* _solver_new(cgame g);
+
+/** copy a solver, which must be at the root of its search */
+solver* _solver_copy(const solver* s);
+
+/** delete a solver */
+void _solver_delete(solver* s);
+
+/** search a solution, which is left in the solver on success (a search
+ * stopped by a limit returns false, see status) */
+bool _solver_solve(solver* s);
+
+/** count the solutions, stopping as soon as limit of them are found
+ * (UINT64_MAX to count them all) */
+uint64_t _solver_count(solver* s, uint64_t limit);
+
+/** prepare a search with propagation that runs in slices: presolve, root
+ * domains and first decision, returns false if the game has no solution */
+bool _solver_start(solver* s);
+
+/** run a search prepared by _solver_start until a solution is found (true,
+ * status SOLVER_FINISHED), a limit is reached (true, with the reason in
+ * status, to be resumed by another call) or the search space is exhausted
+ * (false) */
+bool _solver_resume(solver* s);
+
+/** linear-time checks of necessary conditions, and reduction of the domains
+ * to the orientations allowed by the grid border and by the neighbours known
+ * from their shape alone; returns false if the game has no solution, the
+ * reason being given in the report */
+bool _solver_presolve(solver* s, presolve_report* r);
+
+/** compute the root domains and components (propagation mode), returns
+ * false if the game has no solution */
+bool _solver_init(solver* s);
+
+/** save the current position of the search */
+solver_mark _solver_mark(const solver* s);
+
+/** fix square c to orientation o and propagate, returns false on conflict
+ * (the solver must then be restored to a previous mark) */
+bool _solver_decide(solver* s, uint c, uint o);
+
+/** keep only the orientations of dom on square c and propagate, returns
+ * false on conflict (the solver must then be restored to a previous mark) */
+bool _solver_narrow(solver* s, uint c, uint dom);
+
+/** backtrack to a saved position */
+void _solver_restore(solver* s, solver_mark m);
+
+/** next square to branch on: the fewest remaining orientations, ties broken
+ * by the most fixed neighbours (or NO_CELL if all the pieces are fixed) */
+uint _solver_next_cell(const solver* s);
+
+/** shuffle, with the given seed, the orientation tried first on each square
+ * and the order in which the squares of equal score are branched on */
+void _solver_set_seed(solver* s, uint seed);
+
+/** count the solutions below the current position (up to the limit) */
+uint64_t _solver_count_subtree(solver* s);
+
+/** count the solutions with nb_threads workers, splitting the search tree
+ * into tasks after depth decisions (see game_solver_parallel.c) */
+uint64_t _solver_count_parallel(solver* s, uint nb_threads, uint depth);
+
+/** is the shorter side of the grid small enough for the frontier sweep? */
+bool _solver_frontier_fits(const solver* s);
+
+/** count the solutions with a frontier sweep along the longer side of the
+ * grid (see game_solver_frontier.c) */
+uint64_t _solver_count_frontier(const solver* s);
+
+/** compile all the solutions into a reduced decision diagram with a
+ * frontier sweep, whose states are the nodes (the grid must fit, see
+ * _solver_frontier_fits) */
+solver_zdd* _solver_compile_frontier(const solver* s);
+
+/** create an empty diagram for the grid of s, with its two terminals */
+solver_zdd* _solver_zdd_new(const solver* s);
+
+/** add a node without children, returns its index */
+uint _solver_zdd_add_node(solver_zdd* z);
+
+/** merge the equivalent nodes of a diagram, remove those that lead to no
+ * solution, then count the paths through each node */
+void _solver_zdd_reduce(solver_zdd* z);
+
+/** delete a diagram */
+void _solver_zdd_delete(solver_zdd* z);
+
+/** fraction of the solutions in which square c has orientation o (or an
+ * orientation with the same code) */
+double _solver_zdd_fraction(const solver_zdd* z, uint c, direction o);
+
+/** draw a solution uniformly at random (with rand) into dirs, returns false
+ * if there is none */
+bool _solver_zdd_sample(const solver_zdd* z, direction* dirs);
+
+/** squares whose orientation is the same in all the solutions: forced[c]
+ * tells whether c is one of them, dirs[c] gives its orientation; returns
+ * their number */
+uint _solver_zdd_forced(const solver_zdd* z, bool* forced, direction* dirs);
+
+/** write a diagram to f, as text */
+void _solver_zdd_save(const solver_zdd* z, FILE* f);
+
+/** read a diagram written by _solver_zdd_save, NULL if f does not hold a
+ * valid one */
+solver_zdd* _solver_zdd_load(FILE* f);
+
+/** estimate the number of solutions with random probes, until the
+ * interval of the given confidence is within rel_error of the estimate or
+ * until budget nodes (0: a default budget) have been used; s must be at the
+ * root of its search, it is presolved (see game_solver_estimate.c) */
+solver_estimate _solver_estimate(solver* s, double rel_error,
+                                 double confidence, uint64_t budget);
+
+/** does the grid fit in a 64-bit word, one bit per square? */
+bool _solver_bitboard_fits(const solver* s);
+
+/** count the solutions (up to the limit) with the half-edges of the whole
+ * grid in four 64-bit planes, within the domains of s (presolved); the first
+ * solution is left in s, the limits of the search are ignored (see
+ * game_solver_bitboard.c) */
+uint64_t _solver_count_bitboard(solver* s, uint64_t limit);
+
+/** local search from the current orientations for time_limit seconds:
+ * annealing on the unmatched half-edges, then the regions around what is
+ * left are solved again (see game_solver_local.c); the best state met is
+ * left in s, nb_solutions telling whether it is a solution, returns its
+ * number of unmatched half-edges */
+uint _solver_solve_local(solver* s, double time_limit);
+
+/** solve the grid cut into tiles of the given side (0: a default side),
+ * whose classes of fillings are computed on nb_threads threads (0: all the
+ * cores) then joined; the classes of the tiles left unchanged since the last
+ * call are reused (see game_solver_tiles.c) */
+bool _solver_solve_tiled(solver* s, uint tile_size, uint nb_threads);
+
+/** forget the classes of the tiles kept from the last tiled search */
+void _solver_tiles_clear(void);
+
+/** race nb_configs configurations of the search on as many threads (plain
+ * backtracking, propagation, SAT, then propagation with shuffled orders),
+ * the first one to finish stops the others; the solution is left in s
+ * (see game_solver_portfolio.c) */
+bool _solver_solve_portfolio(solver* s, uint nb_configs);
+
+/** solve the nb_games games, writing the solutions into them; the small
+ * ones are searched side by side, one per lane (see game_solver_batch.c);
+ * solved[k] (if not NULL) tells whether game k was solved, returns the
+ * number of games solved */
+uint _solver_solve_batch(game* games, uint nb_games, bool* solved);
+
+/** search a solution with the SAT backend (see game_solver_sat.c) */
+bool _solver_solve_sat(solver* s);
+
+/** write the CNF encoding of the game to f, in DIMACS format */
+void _solver_export_dimacs(const solver* s, FILE* f);
+
+/** read the number of solutions of the grid of s from the cache, returns
+ * false if it is not known (see game_solver_cache.c) */
+bool _solver_cache_get_count(const solver* s, uint64_t* nb_solutions);
+
+/** save the number of solutions of the grid of s in the cache */
+void _solver_cache_put_count(const solver* s, uint64_t nb_solutions);
+
+/** read a solution of the grid of s from the cache into s, returns 1 if
+ * found, 0 if the grid is known to have no solution, -1 if not known */
+int _solver_cache_get_solution(solver* s);
+
+/** save the outcome of the search of s, and its solution if solved */
+void _solver_cache_put_solution(const solver* s, bool solved);
+
+/** directory of the disk tier of the cache (NULL to disable it) */
+void _solver_cache_set_dir(const char* dir);
+
+/** empty the memory tier of the cache */
+void _solver_cache_clear(void);
+
+/** the state of game g with the solver at its root, the solution being read
+ * from the cache when known and otherwise searched when first needed */
+solver_warm* _solver_warm_new(cgame g);
+
+/** the square c of the game has been turned to orientation o (w may be
+ * NULL) */
+void _solver_warm_update(solver_warm* w, uint c, direction o);
+
+/** a square of game g (whose state is w) to turn and its orientation: first
+ * one fixed by the root propagation or by probing, and only then one that
+ * differs from a solution found by a search with a node budget (a square
+ * that is not forced); returns false if the game is solved, has no solution
+ * or if the budget runs out */
+bool _solver_warm_hint(solver_warm* w, cgame g, uint* cell, direction* o);
+
+/** turn the squares of game g (whose state is w) that differ from the
+ * solution, searched first if needed; returns false if the game has no
+ * solution */
+bool _solver_warm_apply(solver_warm* w, game g);
+
+/** delete the state kept with a game (w may be NULL) */
+void _solver_warm_delete(solver_warm* w);
+
+/** copy the orientations of the solver back into game g */
+void _solver_apply(const solver* s, game g);
+
+#endif  // __GAME_SOLVER_H__
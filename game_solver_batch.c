@@ -0,0 +1,284 @@
+/**
+ * @file game_solver_batch.c
+ * @brief Batch search of many small games, one game per lane.
+ * @details Games of the same size (at most BATCH_MAX_CELLS squares) are
+ * grouped by BATCH_LANES and laid out structure-of-arrays: the shapes, the
+ * codes and the search position of square c are stored for all the lanes
+ * side by side. The lanes then run a row-major backtracking search in
+ * lock-step: at each step, every active lane tries one orientation on its
+ * current square and checks its half-edges against the squares already
+ * assigned, using the same neighbour tables for all the lanes. A lane that
+ * finds its solution, or runs out of orientations, is masked out while the
+ * others go on. The connectivity of a complete assignment is checked with a
+ * flood fill over a 64-bit set of squares.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+/** number of games searched side by side (at most 32, see _lanes_run) */
+#define BATCH_LANES 16
+
+/** largest grid searched in the lanes, the others are solved one by one */
+#define BATCH_MAX_CELLS 64
+
+/** the neighbour is assigned after the square, the edge is checked then */
+#define LATER ((uint)-2)
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** up to BATCH_LANES games of the same size, searched in lock-step */
+typedef struct {
+  uint nb_cells;                       /**< number of squares of a grid */
+  uint nb_lanes;                       /**< number of lanes in use */
+  uint adj[BATCH_MAX_CELLS][NB_DIRS];  /**< square next to c in dir d */
+  uint link[BATCH_MAX_CELLS][NB_DIRS]; /**< the same, or NO_CELL for the
+                                            border, or LATER */
+  unsigned char nb_orients[NB_SHAPES]; /**< distinct orientations */
+  unsigned char orients[NB_SHAPES][NB_DIRS];  /**< list of them */
+  uint64_t pieces[BATCH_LANES];               /**< non-empty squares */
+  int pos[BATCH_LANES]; /**< current square of each lane (-1: exhausted,
+                             nb_cells: complete assignment) */
+  unsigned char shapes[BATCH_MAX_CELLS][BATCH_LANES]; /**< shape of c */
+  unsigned char codes[BATCH_MAX_CELLS][BATCH_LANES];  /**< code of c */
+  unsigned char next[BATCH_MAX_CELLS][BATCH_LANES];   /**< next orientation
+                                                           of c to try */
+} lanes;
+
+/* ************************************************************************** */
+/*                                 LANES                                      */
+/* ************************************************************************** */
+
+/* the distinct orientations of each shape, as in the solver */
+static void _lanes_init_orients(lanes* b) {
+  for (uint sh = 0; sh < NB_SHAPES; sh++) {
+    b->nb_orients[sh] = 0;
+    for (uint o = 0; o < NB_DIRS; o++) {
+      bool seen = false;
+      for (uint k = 0; k < o; k++)
+        if (_code[sh][k] == _code[sh][o]) seen = true;
+      if (!seen) b->orients[sh][b->nb_orients[sh]++] = o;
+    }
+  }
+}
+
+/* ************************************************************************** */
+
+/* load the neighbour tables of the grids of the size of g, with no lane */
+static void _lanes_init_grid(lanes* b, cgame g) {
+  uint nb_cols = game_nb_cols(g);
+  b->nb_cells = game_nb_rows(g) * nb_cols;
+  b->nb_lanes = 0;
+  for (uint c = 0; c < b->nb_cells; c++)
+    for (direction d = 0; d < NB_DIRS; d++) {
+      uint ni, nj;
+      bool next = game_get_ajacent_square(g, c / nb_cols, c % nb_cols, d, &ni,
+                                          &nj);
+      b->adj[c][d] = next ? ni * nb_cols + nj : NO_CELL;
+      b->link[c][d] = (next && b->adj[c][d] > c) ? LATER : b->adj[c][d];
+    }
+}
+
+/* ************************************************************************** */
+
+/* put game g in the next lane */
+static void _lanes_add(lanes* b, cgame g) {
+  uint l = b->nb_lanes++, nb_cols = game_nb_cols(g);
+  b->pieces[l] = 0;
+  b->pos[l] = 0;
+  for (uint c = 0; c < b->nb_cells; c++) {
+    b->shapes[c][l] = game_get_piece_shape(g, c / nb_cols, c % nb_cols);
+    b->next[c][l] = 0;
+    if (b->shapes[c][l] != EMPTY) b->pieces[l] |= (uint64_t)1 << c;
+  }
+}
+
+/* ************************************************************************** */
+
+/* are the pieces of lane l, whose half-edges all match, a single network? */
+static bool _lanes_connected(const lanes* b, uint l) {
+  if (b->pieces[l] == 0) return true;
+  uint stack[BATCH_MAX_CELLS], len = 0, first = 0;
+  while (!(b->pieces[l] & ((uint64_t)1 << first))) first++;
+  uint64_t seen = (uint64_t)1 << first;
+  stack[len++] = first;
+  while (len > 0) {
+    uint c = stack[--len];
+    for (direction d = 0; d < NB_DIRS; d++) {
+      if (!(b->codes[c][l] & DIR_MASK(d))) continue;
+      uint next = b->adj[c][d];
+      if (seen & ((uint64_t)1 << next)) continue;
+      seen |= (uint64_t)1 << next;
+      stack[len++] = next;
+    }
+  }
+  return seen == b->pieces[l];
+}
+
+/* ************************************************************************** */
+
+/* run all the lanes in lock-step until each one is solved or exhausted,
+ * returns the mask of the solved lanes */
+static uint32_t _lanes_run(lanes* b) {
+  uint32_t active = (uint32_t)(((uint64_t)1 << b->nb_lanes) - 1);
+  uint32_t solved = 0;
+  int n = b->nb_cells;
+  while (active) {
+    for (uint l = 0; l < b->nb_lanes; l++) {
+      uint32_t bit = 1u << l;
+      if (!(active & bit)) continue;
+      int c = b->pos[l];
+      if (c == n) {
+        // complete assignment: all its half-edges match
+        if (_lanes_connected(b, l)) {
+          solved |= bit;
+          active &= ~bit;
+        } else
+          b->pos[l] = n - 1;
+        continue;
+      }
+      uint sh = b->shapes[c][l], k = b->next[c][l];
+      if (k == b->nb_orients[sh]) {
+        b->next[c][l] = 0;
+        if (--b->pos[l] < 0) active &= ~bit;
+        continue;
+      }
+      b->next[c][l] = k + 1;
+
+      // edge checks against the border and the squares already assigned
+      uint code = _code[sh][b->orients[sh][k]], bad = 0;
+      for (direction d = 0; d < NB_DIRS; d++) {
+        uint next = b->link[c][d];
+        uint other = (next == NO_CELL || next == LATER) ? 0
+                     : ((int)next == c)                 ? code
+                                                        : b->codes[next][l];
+        uint here = (code & DIR_MASK(d)) != 0;
+        uint there = (other & DIR_MASK((d + 2) % NB_DIRS)) != 0;
+        bad |= (next != LATER) & (here ^ there);
+      }
+      b->codes[c][l] = code;
+      b->pos[l] += !bad;
+    }
+  }
+  return solved;
+}
+
+/* ************************************************************************** */
+
+/* copy the solution of lane l into game g */
+static void _lanes_apply(const lanes* b, uint l, game g) {
+  uint nb_cols = game_nb_cols(g);
+  for (uint c = 0; c < b->nb_cells; c++) {
+    uint i = c / nb_cols, j = c % nb_cols, sh = b->shapes[c][l];
+    // the orientation tried last is the one of the solution
+    direction o = b->orients[sh][b->next[c][l] - 1];
+    if (_code[sh][game_get_piece_orientation(g, i, j)] != _code[sh][o])
+      game_set_piece_orientation(g, i, j, o);
+  }
+}
+
+/* ************************************************************************** */
+/*                                 BATCH                                      */
+/* ************************************************************************** */
+
+/** a game and the key it is sorted by */
+typedef struct {
+  uint nb_rows, nb_cols, wrapping;
+  uint index; /**< position of the game in the batch */
+} batch_key;
+
+/* order of the games: by size, then by index, so that lanes are full */
+static int _batch_compare(const void* a, const void* b) {
+  const batch_key* k1 = (const batch_key*)a;
+  const batch_key* k2 = (const batch_key*)b;
+  uint v1[4] = {k1->nb_rows, k1->nb_cols, k1->wrapping, k1->index};
+  uint v2[4] = {k2->nb_rows, k2->nb_cols, k2->wrapping, k2->index};
+  for (uint k = 0; k < 4; k++)
+    if (v1[k] != v2[k]) return (v1[k] < v2[k]) ? -1 : 1;
+  return 0;
+}
+
+/* ************************************************************************** */
+
+static bool _batch_same_grid(const batch_key* k1, const batch_key* k2) {
+  return k1->nb_rows == k2->nb_rows && k1->nb_cols == k2->nb_cols &&
+         k1->wrapping == k2->wrapping;
+}
+
+/* ************************************************************************** */
+
+/* a game too large for the lanes goes through the solver */
+static bool _batch_solve_one(game g) {
+  solver* s = _solver_new(g);
+  presolve_report report;
+  bool ok = _solver_presolve(s, &report) && _solver_solve(s);
+  if (ok) _solver_apply(s, g);
+  _solver_delete(s);
+  return ok;
+}
+
+/* ************************************************************************** */
+
+uint _solver_solve_batch(game* games, uint nb_games, bool* solved) {
+  assert(games || nb_games == 0);
+  batch_key* keys = (batch_key*)malloc(nb_games * sizeof(batch_key));
+  uint* lane_game = (uint*)malloc(BATCH_LANES * sizeof(uint));
+  lanes* b = (lanes*)malloc(sizeof(lanes));
+  assert((nb_games == 0 || keys) && lane_game && b);
+  for (uint k = 0; k < nb_games; k++) {
+    keys[k].nb_rows = game_nb_rows(games[k]);
+    keys[k].nb_cols = game_nb_cols(games[k]);
+    keys[k].wrapping = game_is_wrapping(games[k]);
+    keys[k].index = k;
+  }
+  qsort(keys, nb_games, sizeof(batch_key), _batch_compare);
+  _lanes_init_orients(b);
+
+  uint nb_solved = 0;
+  for (uint k = 0; k < nb_games;) {
+    const batch_key* first = &keys[k];
+    game g = games[first->index];
+    if (first->nb_rows * first->nb_cols > BATCH_MAX_CELLS) {
+      bool ok = _batch_solve_one(g);
+      if (solved) solved[first->index] = ok;
+      nb_solved += ok;
+      k++;
+      continue;
+    }
+    // fill the lanes with the next games of the same size
+    _lanes_init_grid(b, g);
+    while (k < nb_games && b->nb_lanes < BATCH_LANES &&
+           _batch_same_grid(first, &keys[k])) {
+      lane_game[b->nb_lanes] = keys[k].index;
+      _lanes_add(b, games[keys[k].index]);
+      k++;
+    }
+    uint32_t mask = _lanes_run(b);
+    for (uint l = 0; l < b->nb_lanes; l++) {
+      bool ok = (mask >> l) & 1;
+      if (ok) _lanes_apply(b, l, games[lane_game[l]]);
+      if (solved) solved[lane_game[l]] = ok;
+      nb_solved += ok;
+    }
+  }
+
+  free(keys);
+  free(lane_game);
+  free(b);
+  return nb_solved;
+}
+
+/* ************************************************************************** */
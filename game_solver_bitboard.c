@@ -0,0 +1,271 @@
+/**
+ * @file game_solver_bitboard.c
+ * @brief Bitboard search for the grids of at most 64 squares.
+ * @details The whole grid fits in a 64-bit word, one bit per square in
+ * row-major order. The half-edges of the pieces already assigned are kept in
+ * four planes (N, E, S, W), and the candidate orientations of all the squares
+ * in four more sets of planes. Moving a plane by one square in a direction is
+ * a shift by 1 or by nb_cols, masked on the grid border; when wrapping, the
+ * bits that leave the grid come back on the other side, through a second
+ * shift whose mask is empty otherwise, so both variants run the same code
+ * without a branch. The search assigns the squares in row-major order. At
+ * each node, every unassigned square is checked at once against the
+ * half-edges of its assigned neighbours: a square left without a matching
+ * candidate ends the branch, and the candidates of the next square are read
+ * from the same planes. A piece whose component gets closed before all the
+ * pieces are in it also ends the branch, and the connectivity of a complete
+ * assignment is a bit-parallel flood fill over the four planes.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** the grid, its masks and the half-edge planes */
+typedef struct {
+  uint nb_cols;            /**< shift from a row to the next one */
+  uint wrap_cols;          /**< shift from the last column to the first one */
+  uint wrap_rows;          /**< shift from the last row to the first one */
+  uint64_t all;            /**< all the squares */
+  uint64_t inner_n;        /**< squares with a neighbour in the grid, north */
+  uint64_t inner_e;        /**< the same, east */
+  uint64_t inner_s;        /**< the same, south */
+  uint64_t inner_w;        /**< the same, west */
+  uint64_t wrap_n;         /**< squares of the first row if wrapping, or 0 */
+  uint64_t wrap_e;         /**< squares of the last column if wrapping */
+  uint64_t wrap_s;         /**< squares of the last row if wrapping */
+  uint64_t wrap_w;         /**< squares of the first column if wrapping */
+  uint64_t pieces;         /**< non-empty squares */
+  uint64_t plane[NB_DIRS]; /**< assigned squares with a half-edge in dir d */
+  uint64_t cand[NB_DIRS];  /**< squares with candidate orientation o */
+  uint64_t cand_half[NB_DIRS][NB_DIRS]; /**< squares whose piece, in
+                                             orientation o, has a half-edge in
+                                             dir d */
+} board;
+
+/* ************************************************************************** */
+/*                                 SHIFTS                                     */
+/* ************************************************************************** */
+
+/* move each bit of x to the square next to it, in each direction */
+static inline uint64_t _bb_north(const board* b, uint64_t x) {
+  return (x & b->inner_n) >> b->nb_cols | (x & b->wrap_n) << b->wrap_rows;
+}
+
+static inline uint64_t _bb_east(const board* b, uint64_t x) {
+  return (x & b->inner_e) << 1 | (x & b->wrap_e) >> b->wrap_cols;
+}
+
+static inline uint64_t _bb_south(const board* b, uint64_t x) {
+  return (x & b->inner_s) << b->nb_cols | (x & b->wrap_s) >> b->wrap_rows;
+}
+
+static inline uint64_t _bb_west(const board* b, uint64_t x) {
+  return (x & b->inner_w) >> 1 | (x & b->wrap_w) << b->wrap_cols;
+}
+
+/* ************************************************************************** */
+
+/* squares reached from those of x through one of their half-edges */
+static inline uint64_t _bb_spread(const board* b, uint64_t x) {
+  const uint64_t* p = b->plane;
+  return _bb_north(b, x & p[NORTH]) | _bb_east(b, x & p[EAST]) |
+         _bb_south(b, x & p[SOUTH]) | _bb_west(b, x & p[WEST]);
+}
+
+/* ************************************************************************** */
+/*                                 CHECKS                                     */
+/* ************************************************************************** */
+
+/* placing code on square c (the squares before it assigned, with the
+ * candidate orientations alive), does each unassigned square keep one
+ * matching the half-edges of its assigned neighbours? those left are written
+ * in next */
+static bool _bb_viable(const board* b, uint c, uint code,
+                       const uint64_t* alive, uint64_t* next) {
+  uint64_t bit = (uint64_t)1 << c;
+  // squares whose neighbour in dir d is c, and whether c faces them with a
+  // half-edge (all ones) or not
+  uint64_t facing[NB_DIRS] = {_bb_south(b, bit), _bb_west(b, bit),
+                              _bb_north(b, bit), _bb_east(b, bit)};
+  uint64_t half[NB_DIRS];
+  for (direction d = 0; d < NB_DIRS; d++)
+    half[d] = -(uint64_t)((code & DIR_MASK((d + 2) % NB_DIRS)) != 0);
+  uint64_t live = 0;
+  for (uint o = 0; o < NB_DIRS; o++) {
+    const uint64_t* h = b->cand_half[o];
+    uint64_t bad = (facing[NORTH] & (h[NORTH] ^ half[NORTH])) |
+                   (facing[EAST] & (h[EAST] ^ half[EAST])) |
+                   (facing[SOUTH] & (h[SOUTH] ^ half[SOUTH])) |
+                   (facing[WEST] & (h[WEST] ^ half[WEST]));
+    next[o] = alive[o] & ~bad;
+    live |= next[o];
+  }
+  uint64_t left = b->all & ~(~(uint64_t)0 >> (63 - c));
+  return (left & ~live) == 0;
+}
+
+/* ************************************************************************** */
+
+/* once square c is placed, is its component closed, with no half-edge left
+ * towards an unassigned square, while other pieces are not in it? */
+static bool _bb_closed(const board* b, uint c) {
+  uint64_t a = ~(uint64_t)0 >> (63 - c), seen = (uint64_t)1 << c, last;
+  if (!(b->pieces & seen)) return false;
+  do {
+    last = seen;
+    uint64_t next = _bb_spread(b, seen);
+    if (next & ~a) return false;
+    seen |= next;
+  } while (seen != last);
+  return (b->pieces & ~seen) != 0;
+}
+
+/* ************************************************************************** */
+
+/* is the network of a complete, matched assignment a single component? */
+static bool _bb_connected(const board* b) {
+  if (b->pieces == 0) return true;
+  uint64_t seen = b->pieces & -b->pieces, last;
+  do {
+    last = seen;
+    seen |= _bb_spread(b, seen);
+  } while (seen != last);
+  return seen == b->pieces;
+}
+
+/* ************************************************************************** */
+/*                                 SEARCH                                     */
+/* ************************************************************************** */
+
+/* set the half-edges of square c to those of code (0 clears them) */
+static inline void _bb_set(board* b, uint c, uint code) {
+  uint64_t bit = (uint64_t)1 << c;
+  for (direction d = 0; d < NB_DIRS; d++)
+    b->plane[d] = (b->plane[d] & ~bit) |
+                  ((uint64_t)((code & DIR_MASK(d)) != 0) << c);
+}
+
+/* ************************************************************************** */
+
+/* masks of the grid of s */
+static void _bb_init_grid(board* b, const solver* s) {
+  uint n = s->nb_cells, cols = s->nb_cols;
+  uint64_t first_col = 0, last_col = 0;
+  for (uint c = 0; c < n; c += cols) {
+    first_col |= (uint64_t)1 << c;
+    last_col |= (uint64_t)1 << (c + cols - 1);
+  }
+  b->all = ~(uint64_t)0 >> (64 - n);
+  uint64_t first_row = b->all >> (n - cols);
+  uint64_t last_row = first_row << (n - cols);
+  b->nb_cols = cols;
+  b->wrap_cols = cols - 1;
+  b->wrap_rows = n - cols;
+  b->inner_n = b->all & ~first_row;
+  b->inner_e = b->all & ~last_col;
+  b->inner_s = b->all & ~last_row;
+  b->inner_w = b->all & ~first_col;
+  b->wrap_n = s->wrapping ? first_row : 0;
+  b->wrap_e = s->wrapping ? last_col : 0;
+  b->wrap_s = s->wrapping ? last_row : 0;
+  b->wrap_w = s->wrapping ? first_col : 0;
+}
+
+/* ************************************************************************** */
+
+bool _solver_bitboard_fits(const solver* s) {
+  return s->nb_cells > 0 && s->nb_cells <= 64;
+}
+
+/* ************************************************************************** */
+
+uint64_t _solver_count_bitboard(solver* s, uint64_t limit) {
+  assert(s && _solver_bitboard_fits(s) && limit > 0);
+  uint n = s->nb_cells;
+  board b;
+  _bb_init_grid(&b, s);
+
+  // the shapes and the domains, as planes
+  uint64_t shapes[NB_SHAPES] = {0}, doms[NB_DIRS] = {0};
+  for (uint c = 0; c < n; c++) {
+    uint64_t bit = (uint64_t)1 << c;
+    shapes[s->shapes[c]] |= bit;
+    for (uint o = 0; o < NB_DIRS; o++)
+      doms[o] |= bit & -(uint64_t)((s->doms[c] >> o) & 1);
+  }
+  b.pieces = b.all & ~shapes[EMPTY];
+
+  // candidate orientations: those left in the domains, without a half-edge
+  // out of the grid, nor one facing a missing half-edge of the square itself
+  // (when it wraps onto it)
+  uint64_t out[NB_DIRS] = {b.all & ~b.inner_n & ~b.wrap_n,
+                           b.all & ~b.inner_e & ~b.wrap_e,
+                           b.all & ~b.inner_s & ~b.wrap_s,
+                           b.all & ~b.inner_w & ~b.wrap_w};
+  uint64_t self_ns = (s->wrapping && s->nb_rows == 1) ? b.all : 0;
+  uint64_t self_ew = (s->wrapping && s->nb_cols == 1) ? b.all : 0;
+  for (uint o = 0; o < NB_DIRS; o++) {
+    uint64_t* half = b.cand_half[o];
+    for (direction d = 0; d < NB_DIRS; d++) {
+      half[d] = 0;
+      for (uint sh = 0; sh < NB_SHAPES; sh++)
+        if (_code[sh][o] & DIR_MASK(d)) half[d] |= shapes[sh];
+    }
+    b.cand[o] = doms[o];
+    for (direction d = 0; d < NB_DIRS; d++) b.cand[o] &= ~(half[d] & out[d]);
+    b.cand[o] &= ~(self_ns & (half[NORTH] ^ half[SOUTH]));
+    b.cand[o] &= ~(self_ew & (half[EAST] ^ half[WEST]));
+  }
+
+  // row-major depth-first search, trying the orientations of each square
+  // from the current one on: next[c] of them are tried; alive[c][o]: the
+  // squares that can take orientation o, given the squares before c (the
+  // planes of the squares after c are never read)
+  uint64_t alive[65][NB_DIRS], live = 0, nb_solutions = 0;
+  unsigned char next[64];
+  for (uint o = 0; o < NB_DIRS; o++) live |= alive[0][o] = b.cand[o];
+  uint c = 0;
+  next[0] = 0;
+  while (live == b.all) {
+    if (c == n) {
+      if (_bb_connected(&b) && nb_solutions++ == 0)
+        for (uint q = 0; q < n; q++) {
+          s->dirs[q] = (s->prefs[q] + next[q] - 1) % NB_DIRS;
+          s->codes[q] = _code[s->shapes[q]][s->dirs[q]];
+        }
+      if (nb_solutions >= limit) break;
+      c--;
+      continue;
+    }
+    uint sh = s->shapes[c];
+    bool placed = false;
+    while (!placed && next[c] < NB_DIRS) {
+      uint o = (s->prefs[c] + next[c]++) % NB_DIRS, code = _code[sh][o];
+      if (!((alive[c][o] >> c) & 1) ||
+          !_bb_viable(&b, c, code, alive[c], alive[c + 1]))
+        continue;
+      _bb_set(&b, c, code);
+      placed = !_bb_closed(&b, c);
+    }
+    if (placed) {
+      if (++c < n) next[c] = 0;
+    } else if (c-- == 0)
+      break;
+  }
+  s->nb_solutions = nb_solutions;
+  return nb_solutions;
+}
+
+/* ************************************************************************** */
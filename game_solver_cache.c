@@ -0,0 +1,298 @@
+/**
+ * @file game_solver_cache.c
+ * @brief Cache of the solutions already computed.
+ * @details The solutions of a game only depend on its dimensions, on its
+ * wrapping option and on the shapes of its pieces, never on their current
+ * orientations. Both the number of solutions and one solution are kept for
+ * each such grid, in two tiers:
+ *  - in memory, the CACHE_SIZE grids used most recently (LRU);
+ *  - on disk (optional, see _solver_cache_set_dir), one small text file per
+ *    grid, named after its hash:
+ *      <nb_rows> <nb_cols> <wrapping>
+ *      <solved: -1 unknown, 0 no solution, 1 found> <nb_solutions or -1>
+ *      one line per row, a shape digit and an orientation digit per square
+ * Entries are found by a 64-bit hash, then checked square by square, so that
+ * two grids with the same hash never share their solutions.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+/** number of grids kept in memory */
+#define CACHE_SIZE 32
+
+/** largest length of the path of a file of the disk tier */
+#define CACHE_PATH_LEN 4096
+
+/** a grid and what is known about its solutions */
+typedef struct {
+  uint64_t key;          /**< hash of the grid (0: free entry) */
+  uint64_t last_use;     /**< time stamp of the last lookup, for LRU */
+  uint nb_rows;          /**< number of rows */
+  uint nb_cols;          /**< number of columns */
+  bool wrapping;         /**< the wrapping option */
+  unsigned char* shapes; /**< shape of each square */
+  direction* dirs;       /**< orientations of the solution, if found */
+  int solved;            /**< -1 unknown, 0 no solution, 1 found */
+  bool counted;          /**< is the number of solutions known? */
+  uint64_t nb_solutions; /**< number of solutions, if counted */
+} cache_entry;
+
+static cache_entry _entries[CACHE_SIZE];
+static uint64_t _clock = 0;
+static char* _dir = NULL;
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ************************************************************************** */
+/*                                 ENTRIES                                    */
+/* ************************************************************************** */
+
+/* FNV-1a hash of the grid, never 0 */
+static uint64_t _cache_key(const solver* s) {
+  uint64_t h = 14695981039346656037ULL;
+  uint64_t head[3] = {s->nb_rows, s->nb_cols, s->wrapping};
+  for (uint k = 0; k < 3; k++) h = (h ^ head[k]) * 1099511628211ULL;
+  for (uint c = 0; c < s->nb_cells; c++)
+    h = (h ^ s->shapes[c]) * 1099511628211ULL;
+  return h ? h : 1;
+}
+
+/* ************************************************************************** */
+
+/* does entry e hold the grid of solver s? */
+static bool _cache_match(const cache_entry* e, const solver* s, uint64_t key) {
+  return e->key == key && e->nb_rows == s->nb_rows &&
+         e->nb_cols == s->nb_cols && e->wrapping == s->wrapping &&
+         memcmp(e->shapes, s->shapes, s->nb_cells) == 0;
+}
+
+/* ************************************************************************** */
+
+/* reset entry e to the grid of solver s, with nothing known about it */
+static void _cache_reset(cache_entry* e, const solver* s, uint64_t key) {
+  free(e->shapes);
+  free(e->dirs);
+  e->key = key;
+  e->nb_rows = s->nb_rows;
+  e->nb_cols = s->nb_cols;
+  e->wrapping = s->wrapping;
+  e->shapes = (unsigned char*)malloc(s->nb_cells * sizeof(unsigned char));
+  e->dirs = (direction*)malloc(s->nb_cells * sizeof(direction));
+  assert(s->nb_cells == 0 || (e->shapes && e->dirs));
+  memcpy(e->shapes, s->shapes, s->nb_cells * sizeof(unsigned char));
+  e->solved = -1;
+  e->counted = false;
+  e->nb_solutions = 0;
+}
+
+/* ************************************************************************** */
+/*                                DISK TIER                                   */
+/* ************************************************************************** */
+
+static bool _cache_path(uint64_t key, char* path) {
+  if (!_dir) return false;
+  int len = snprintf(path, CACHE_PATH_LEN, "%s/%016" PRIx64 ".sol", _dir, key);
+  return len > 0 && len < CACHE_PATH_LEN;
+}
+
+/* ************************************************************************** */
+
+/* read the file of the grid of solver s into entry e, returns false if there
+ * is none (or if it holds another grid) */
+static bool _cache_load(cache_entry* e, const solver* s, uint64_t key) {
+  char path[CACHE_PATH_LEN];
+  if (!_cache_path(key, path)) return false;
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+
+  uint nb_rows, nb_cols, wrapping;
+  int solved;
+  long long nb_solutions;
+  bool ok = fscanf(f, "%u %u %u %d %lld", &nb_rows, &nb_cols, &wrapping,
+                   &solved, &nb_solutions) == 5 &&
+            nb_rows == s->nb_rows && nb_cols == s->nb_cols &&
+            wrapping == s->wrapping && solved >= -1 && solved <= 1;
+  if (ok) _cache_reset(e, s, key);
+  for (uint c = 0; c < s->nb_cells && ok; c++) {
+    char sh, dir;
+    ok = fscanf(f, " %c%c", &sh, &dir) == 2 && sh - '0' == s->shapes[c] &&
+         dir >= '0' && dir < '0' + NB_DIRS;
+    if (ok) e->dirs[c] = dir - '0';
+  }
+  fclose(f);
+  if (!ok) {
+    e->key = 0;
+    return false;
+  }
+  e->solved = solved;
+  e->counted = nb_solutions >= 0;
+  e->nb_solutions = e->counted ? (uint64_t)nb_solutions : 0;
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* write entry e to its file, if the disk tier is enabled */
+static void _cache_store(const cache_entry* e) {
+  char path[CACHE_PATH_LEN];
+  if (!_cache_path(e->key, path)) return;
+  FILE* f = fopen(path, "w");
+  if (!f) return;
+  fprintf(f, "%u %u %u\n", e->nb_rows, e->nb_cols, e->wrapping ? 1 : 0);
+  fprintf(f, "%d %lld\n", e->solved,
+          e->counted ? (long long)e->nb_solutions : -1LL);
+  for (uint i = 0; i < e->nb_rows; i++)
+    for (uint j = 0; j < e->nb_cols; j++) {
+      uint c = i * e->nb_cols + j;
+      uint dir = (e->solved == 1) ? e->dirs[c] : 0;
+      fprintf(f, "%u%u%c", e->shapes[c], dir,
+              (j + 1 < e->nb_cols) ? ' ' : '\n');
+    }
+  fclose(f);
+}
+
+/* ************************************************************************** */
+/*                                  LOOKUP                                    */
+/* ************************************************************************** */
+
+/* entry of the grid of solver s, loaded from disk if needed, or NULL if it is
+ * not cached (must be called with the lock held) */
+static cache_entry* _cache_find(const solver* s, uint64_t key) {
+  for (uint k = 0; k < CACHE_SIZE; k++)
+    if (_cache_match(&_entries[k], s, key)) {
+      _entries[k].last_use = ++_clock;
+      return &_entries[k];
+    }
+  if (!_dir) return NULL;
+  cache_entry tmp = {0};
+  if (!_cache_load(&tmp, s, key)) {
+    free(tmp.shapes);
+    free(tmp.dirs);
+    return NULL;
+  }
+  // the grid replaces the least recently used one
+  cache_entry* lru = &_entries[0];
+  for (uint k = 1; k < CACHE_SIZE; k++)
+    if (_entries[k].last_use < lru->last_use) lru = &_entries[k];
+  free(lru->shapes);
+  free(lru->dirs);
+  *lru = tmp;
+  lru->last_use = ++_clock;
+  return lru;
+}
+
+/* ************************************************************************** */
+
+/* entry of the grid of solver s, created if needed (lock held) */
+static cache_entry* _cache_get(const solver* s, uint64_t key) {
+  cache_entry* e = _cache_find(s, key);
+  if (e) return e;
+  e = &_entries[0];
+  for (uint k = 1; k < CACHE_SIZE; k++)
+    if (_entries[k].last_use < e->last_use) e = &_entries[k];
+  _cache_reset(e, s, key);
+  e->last_use = ++_clock;
+  return e;
+}
+
+/* ************************************************************************** */
+/*                                  ROUTINES                                  */
+/* ************************************************************************** */
+
+bool _solver_cache_get_count(const solver* s, uint64_t* nb_solutions) {
+  assert(s && nb_solutions);
+  uint64_t key = _cache_key(s);
+  pthread_mutex_lock(&_lock);
+  cache_entry* e = _cache_find(s, key);
+  bool found = e && (e->counted || e->solved == 0);
+  if (found) *nb_solutions = e->counted ? e->nb_solutions : 0;
+  pthread_mutex_unlock(&_lock);
+  return found;
+}
+
+/* ************************************************************************** */
+
+void _solver_cache_put_count(const solver* s, uint64_t nb_solutions) {
+  assert(s);
+  uint64_t key = _cache_key(s);
+  pthread_mutex_lock(&_lock);
+  cache_entry* e = _cache_get(s, key);
+  e->counted = true;
+  e->nb_solutions = nb_solutions;
+  if (nb_solutions == 0) e->solved = 0;
+  _cache_store(e);
+  pthread_mutex_unlock(&_lock);
+}
+
+/* ************************************************************************** */
+
+int _solver_cache_get_solution(solver* s) {
+  assert(s);
+  uint64_t key = _cache_key(s);
+  pthread_mutex_lock(&_lock);
+  cache_entry* e = _cache_find(s, key);
+  int solved = -1;
+  if (e && e->counted && e->nb_solutions == 0) solved = 0;
+  if (e && e->solved >= 0) solved = e->solved;
+  if (solved == 1)
+    for (uint c = 0; c < s->nb_cells; c++) {
+      s->dirs[c] = e->dirs[c];
+      s->codes[c] = _code[s->shapes[c]][e->dirs[c]];
+    }
+  pthread_mutex_unlock(&_lock);
+  return solved;
+}
+
+/* ************************************************************************** */
+
+void _solver_cache_put_solution(const solver* s, bool solved) {
+  assert(s);
+  uint64_t key = _cache_key(s);
+  pthread_mutex_lock(&_lock);
+  cache_entry* e = _cache_get(s, key);
+  e->solved = solved ? 1 : 0;
+  if (solved) memcpy(e->dirs, s->dirs, s->nb_cells * sizeof(direction));
+  _cache_store(e);
+  pthread_mutex_unlock(&_lock);
+}
+
+/* ************************************************************************** */
+
+void _solver_cache_set_dir(const char* dir) {
+  pthread_mutex_lock(&_lock);
+  free(_dir);
+  _dir = NULL;
+  if (dir) {
+    _dir = (char*)malloc(strlen(dir) + 1);
+    assert(_dir);
+    strcpy(_dir, dir);
+  }
+  pthread_mutex_unlock(&_lock);
+}
+
+/* ************************************************************************** */
+
+void _solver_cache_clear(void) {
+  pthread_mutex_lock(&_lock);
+  for (uint k = 0; k < CACHE_SIZE; k++) {
+    free(_entries[k].shapes);
+    free(_entries[k].dirs);
+    memset(&_entries[k], 0, sizeof(cache_entry));
+  }
+  pthread_mutex_unlock(&_lock);
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,199 @@
+/**
+ * @file game_solver_estimate.c
+ * @brief Estimate of the number of solutions by random probes.
+ * @details Counting all the solutions of a large grid may take years, while
+ * an order of magnitude is often enough. A probe (Knuth's estimator) goes
+ * down a single random branch of the search tree: the squares not fixed
+ * yet are taken in row-major order, each orientation left is tried with
+ * propagation, and one of those that survive is drawn uniformly. The
+ * product of the numbers of survivors along the branch (0 if none is left
+ * on the way) is an unbiased estimate of the number of solutions: each
+ * solution is reached with a probability that is exactly its inverse. The
+ * last ESTIMATE_EXACT_PIECES pieces of a branch are counted exactly instead,
+ * which also checks the connectivity of the solutions reached.
+ * The probes are repeated until the confidence interval of their mean
+ * (normal approximation) is within the relative error asked, or until the
+ * budget of nodes is used up, which the result tells apart. The variance of
+ * the estimator can be large on grids with very uneven subtrees, the
+ * interval then being too optimistic until enough probes have been drawn;
+ * with fewer than two probes it is unbounded.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+/** pieces left at the end of a probe, whose solutions are counted exactly */
+#define ESTIMATE_EXACT_PIECES 8
+
+/** probes drawn before the interval is trusted */
+#define ESTIMATE_MIN_PROBES 32
+
+/** nodes used when no budget is given */
+#define ESTIMATE_BUDGET 2000000
+
+/* ************************************************************************** */
+
+/** state of the probes */
+typedef struct {
+  solver* s;         /**< the solver, at the root of its search */
+  uint64_t rng;      /**< state of the xorshift generator */
+  uint* order;       /**< squares left at the end of a probe */
+  uint64_t nb_nodes; /**< nodes of all the probes so far */
+} estimate;
+
+/* ************************************************************************** */
+
+static uint64_t _estimate_rand(estimate* e) {
+  e->rng ^= e->rng << 13;
+  e->rng ^= e->rng >> 7;
+  e->rng ^= e->rng << 17;
+  return e->rng;
+}
+
+/* ************************************************************************** */
+
+/* the value z such that a normal variable lies within z standard deviations
+ * of its mean with the given probability (by bisection on erfc) */
+static double _estimate_quantile(double confidence) {
+  double lo = 0.0, hi = 40.0;
+  for (uint k = 0; k < 100; k++) {
+    double mid = (lo + hi) / 2;
+    if (erfc(mid / sqrt(2.0)) > 1.0 - confidence)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+/* ************************************************************************** */
+
+/* exact number of solutions below the current position, the squares left
+ * being searched through order (nb_order of them) */
+static double _estimate_count(estimate* e, uint nb_order) {
+  solver* s = e->s;
+  uint* order = s->order;
+  uint len = s->nb_order;
+  s->order = e->order;
+  s->nb_order = nb_order;
+  s->limit = UINT64_MAX;
+  s->nb_nodes = 0;
+  s->status = SOLVER_FINISHED;
+  s->deadline = 0;
+  double nb_solutions = (double)_solver_count_subtree(s);
+  e->nb_nodes += s->nb_nodes;
+  s->order = order;
+  s->nb_order = len;
+  return nb_solutions;
+}
+
+/* ************************************************************************** */
+
+/* one probe from the root, returns its estimate of the number of solutions;
+ * the solver is left at the root */
+static double _estimate_probe(estimate* e) {
+  solver* s = e->s;
+  solver_mark root = _solver_mark(s);
+  double weight = 1.0;
+  uint c = 0;
+  while (s->nb_pieces - s->nb_placed > ESTIMATE_EXACT_PIECES) {
+    while (s->placed[c]) c++;
+    uint alive[NB_DIRS], nb_alive = 0;
+    for (uint o = 0; o < NB_DIRS; o++) {
+      if (!(s->doms[c] & (1 << o))) continue;
+      solver_mark m = _solver_mark(s);
+      e->nb_nodes++;
+      if (_solver_decide(s, c, o)) alive[nb_alive++] = o;
+      _solver_restore(s, m);
+    }
+    if (nb_alive == 0) {
+      weight = 0.0;
+      break;
+    }
+    weight *= nb_alive;
+    // a decision already tried above, which cannot fail
+    _solver_decide(s, c, alive[_estimate_rand(e) % nb_alive]);
+  }
+
+  // the squares left are all after c
+  if (weight > 0.0) {
+    uint nb_order = 0;
+    for (uint k = c; k < s->nb_cells; k++)
+      if (!s->placed[k]) e->order[nb_order++] = k;
+    weight *= _estimate_count(e, nb_order);
+  }
+  _solver_restore(s, root);
+  return weight;
+}
+
+/* ************************************************************************** */
+
+solver_estimate _solver_estimate(solver* s, double rel_error,
+                                 double confidence, uint64_t budget) {
+  assert(s && s->trail_len == 0);
+  assert(confidence > 0.0 && confidence < 1.0);
+  if (budget == 0) budget = ESTIMATE_BUDGET;
+  solver_estimate r = {0.0, 0.0, 0.0, 0, true, true};
+  presolve_report report;
+  if (!_solver_presolve(s, &report) || !_solver_init(s)) return r;
+
+  estimate e;
+  e.s = s;
+  e.rng = 0x9E3779B97F4A7C15ull ^ s->nb_cells;
+  e.order = (uint*)malloc(s->nb_cells * sizeof(uint));
+  assert(s->nb_cells == 0 || e.order);
+  e.nb_nodes = 0;
+
+  // few pieces: a single probe counts them all
+  if (s->nb_pieces - s->nb_placed <= ESTIMATE_EXACT_PIECES) {
+    r.estimate = r.low = r.high = _estimate_probe(&e);
+    r.nb_probes = 1;
+    free(e.order);
+    return r;
+  }
+
+  // mean and variance of the probes (Welford)
+  double z = _estimate_quantile(confidence), mean = 0.0, m2 = 0.0;
+  double half = 0.0;
+  bool found = false;
+  r.exact = false;
+  r.converged = false;
+  while (e.nb_nodes < budget) {
+    double x = _estimate_probe(&e);
+    found = found || x > 0.0;
+    r.nb_probes++;
+    double delta = x - mean;
+    mean += delta / r.nb_probes;
+    m2 += delta * (x - mean);
+    if (r.nb_probes < 2) continue;
+    half = z * sqrt(m2 / (r.nb_probes - 1) / r.nb_probes);
+    if (r.nb_probes >= ESTIMATE_MIN_PROBES && mean > 0.0 &&
+        half <= rel_error * mean) {
+      r.converged = true;
+      break;
+    }
+  }
+  free(e.order);
+  // a single probe says nothing of the variance
+  if (r.nb_probes < 2) half = INFINITY;
+
+  // a probe that reached a solution proves there is one
+  r.estimate = mean;
+  r.low = mean - half;
+  if (r.low < (found ? 1.0 : 0.0)) r.low = found ? 1.0 : 0.0;
+  r.high = (mean + half > r.low) ? mean + half : r.low;
+  return r;
+}
+
+/* ************************************************************************** */
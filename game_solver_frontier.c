@@ -0,0 +1,490 @@
+/**
+ * @file game_solver_frontier.c
+ * @brief Frontier dynamic programming to count the solutions.
+ * @details The grid is swept square by square, in row-major order along its
+ * longer side. After each square, the solutions of the part already swept
+ * are summarized by the half-edges crossing the frontier (the plugs) and by
+ * the components they belong to. A hash map gives the number of partial
+ * solutions for each such state, so that the counting time grows linearly
+ * with the longer side of the grid.
+ *
+ * A state is stored in a 64-bit key, 4 bits per slot:
+ *  - slots 0..w-1: vertical plugs, entering the current row from above for
+ *    the columns not yet swept, leaving it downward for the others;
+ *  - slot w: horizontal plug entering the current square from the left;
+ *  - slots w+1..2w (wrapping only): vertical plugs entering row 0 from the
+ *    last row, kept until the end to be joined with the last row;
+ *  - slot 2w+1 (wrapping only): horizontal plug entering column 0 from the
+ *    last column, kept until the end of the row.
+ * A slot holds 0 if there is no half-edge, or else the label of its
+ * component. Labels are numbered by order of first appearance, so that equal
+ * states have equal keys. One extra bit tells that a component has already
+ * been closed: no other piece may then appear.
+ *
+ * The same sweep compiles all the solutions into a decision diagram (see
+ * game_solver_zdd.c), each state being a node. The plugs crossing the border
+ * of a wrapping grid are not guessed then, but given by the orientations of
+ * the first row and of the first column, so that a state only has one child
+ * per orientation of the next square.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+#define MAX_SLOTS 15
+#define DONE_BIT ((uint64_t)1 << (4 * MAX_SLOTS))
+#define NO_KEY UINT64_MAX
+
+/* ************************************************************************** */
+/*                                HASH MAP                                    */
+/* ************************************************************************** */
+
+/** hash map from states to numbers of partial solutions (open addressing) */
+typedef struct {
+  uint64_t* keys;
+  uint64_t* vals;
+  uint capacity; /**< always a power of 2 */
+  uint len;
+} fmap;
+
+static void _fmap_init(fmap* m, uint capacity) {
+  m->capacity = capacity;
+  m->len = 0;
+  m->keys = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+  m->vals = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+  assert(m->keys && m->vals);
+  for (uint k = 0; k < capacity; k++) m->keys[k] = NO_KEY;
+}
+
+/* ************************************************************************** */
+
+static void _fmap_free(fmap* m) {
+  free(m->keys);
+  free(m->vals);
+}
+
+/* ************************************************************************** */
+
+static uint _fmap_hash(uint64_t key, uint capacity) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  return (uint)key & (capacity - 1);
+}
+
+/* ************************************************************************** */
+
+static void _fmap_add(fmap* m, uint64_t key, uint64_t val);
+
+static void _fmap_grow(fmap* m) {
+  fmap bigger;
+  _fmap_init(&bigger, 2 * m->capacity);
+  for (uint k = 0; k < m->capacity; k++)
+    if (m->keys[k] != NO_KEY) _fmap_add(&bigger, m->keys[k], m->vals[k]);
+  _fmap_free(m);
+  *m = bigger;
+}
+
+/* ************************************************************************** */
+
+static void _fmap_add(fmap* m, uint64_t key, uint64_t val) {
+  if (2 * (m->len + 1) > m->capacity) _fmap_grow(m);
+  uint k = _fmap_hash(key, m->capacity);
+  while (m->keys[k] != NO_KEY && m->keys[k] != key)
+    k = (k + 1) & (m->capacity - 1);
+  if (m->keys[k] == NO_KEY) {
+    m->keys[k] = key;
+    m->vals[k] = 0;
+    m->len++;
+  }
+  m->vals[k] += val;
+}
+
+/* ************************************************************************** */
+
+/* the value of key, added with value val if the key is new */
+static uint64_t _fmap_get(fmap* m, uint64_t key, uint64_t val) {
+  if (2 * (m->len + 1) > m->capacity) _fmap_grow(m);
+  uint k = _fmap_hash(key, m->capacity);
+  while (m->keys[k] != NO_KEY && m->keys[k] != key)
+    k = (k + 1) & (m->capacity - 1);
+  if (m->keys[k] == NO_KEY) {
+    m->keys[k] = key;
+    m->vals[k] = val;
+    m->len++;
+  }
+  return m->vals[k];
+}
+
+/* ************************************************************************** */
+
+static void _fmap_clear(fmap* m) {
+  for (uint k = 0; k < m->capacity; k++) m->keys[k] = NO_KEY;
+  m->len = 0;
+}
+
+/* ************************************************************************** */
+/*                                 STATES                                     */
+/* ************************************************************************** */
+
+/** an unpacked state */
+typedef struct {
+  uint nb_slots;
+  unsigned char lab[MAX_SLOTS];
+  bool done;
+} fstate;
+
+static void _fstate_unpack(uint64_t key, uint nb_slots, fstate* st) {
+  st->nb_slots = nb_slots;
+  for (uint k = 0; k < nb_slots; k++) st->lab[k] = (key >> (4 * k)) & 0xF;
+  st->done = (key & DONE_BIT) != 0;
+}
+
+/* ************************************************************************** */
+
+/* pack a state, renumbering the labels by order of first appearance */
+static uint64_t _fstate_pack(const fstate* st) {
+  unsigned char relabel[MAX_SLOTS + 1] = {0};
+  uint next = 1;
+  uint64_t key = st->done ? DONE_BIT : 0;
+  for (uint k = 0; k < st->nb_slots; k++) {
+    uint l = st->lab[k];
+    if (l == 0) continue;
+    if (relabel[l] == 0) relabel[l] = next++;
+    key |= (uint64_t)relabel[l] << (4 * k);
+  }
+  return key;
+}
+
+/* ************************************************************************** */
+
+static uint _fstate_fresh(const fstate* st) {
+  uint max = 0;
+  for (uint k = 0; k < st->nb_slots; k++)
+    if (st->lab[k] > max) max = st->lab[k];
+  assert(max < MAX_SLOTS);
+  return max + 1;
+}
+
+/* ************************************************************************** */
+
+static void _fstate_merge(fstate* st, uint from, uint to) {
+  for (uint k = 0; k < st->nb_slots; k++)
+    if (st->lab[k] == from) st->lab[k] = to;
+}
+
+/* ************************************************************************** */
+
+/* check if the component l still has a plug after a change, and if not,
+ * close it: this is only allowed when it is the last component */
+static bool _fstate_close(fstate* st, uint l) {
+  bool other = false;
+  for (uint k = 0; k < st->nb_slots; k++) {
+    if (st->lab[k] == l) return true;
+    if (st->lab[k] != 0) other = true;
+  }
+  if (other) return false;
+  st->done = true;
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* end of a row (wrapping only): join the plug leaving the last column with
+ * the anchor, returns false if only one of them is there */
+static bool _fstate_end_row(fstate* st, uint left, uint anchor) {
+  uint a = st->lab[left], b = st->lab[anchor];
+  if ((a != 0) != (b != 0)) return false;
+  st->lab[left] = st->lab[anchor] = 0;
+  if (a == 0) return true;
+  if (a != b) _fstate_merge(st, a, b);
+  return _fstate_close(st, b);
+}
+
+/* ************************************************************************** */
+
+/* end of the sweep: join the plugs leaving the last row with those entering
+ * row 0 (slots top..top+w-1, wrapping only), all the plugs left must then
+ * belong to a single component */
+static bool _fstate_accept(const fstate* st, uint w, uint top, bool wrapping) {
+  unsigned char parent[MAX_SLOTS + 1];
+  for (uint l = 0; l <= MAX_SLOTS; l++) parent[l] = l;
+  for (uint j = 0; j < w && wrapping; j++) {
+    uint a = st->lab[j], b = st->lab[top + j];
+    if ((a != 0) != (b != 0)) return false;
+    if (a == 0) continue;
+    while (parent[a] != a) a = parent[a];
+    while (parent[b] != b) b = parent[b];
+    parent[a] = b;
+  }
+  uint root = 0;
+  for (uint q = 0; q < st->nb_slots; q++) {
+    uint l = st->lab[q];
+    if (l == 0) continue;
+    while (parent[l] != l) l = parent[l];
+    if (root == 0) root = l;
+    if (l != root) return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+/*                                 SWEEP                                      */
+/* ************************************************************************** */
+
+/* swap the bits of a code when the grid is transposed (N <-> W, E <-> S) */
+static uint _transpose_code(uint code) {
+  uint t = 0;
+  if (code & DIR_MASK(NORTH)) t |= DIR_MASK(WEST);
+  if (code & DIR_MASK(WEST)) t |= DIR_MASK(NORTH);
+  if (code & DIR_MASK(EAST)) t |= DIR_MASK(SOUTH);
+  if (code & DIR_MASK(SOUTH)) t |= DIR_MASK(EAST);
+  return t;
+}
+
+/* ************************************************************************** */
+
+bool _solver_frontier_fits(const solver* s) {
+  uint width = (s->nb_rows < s->nb_cols) ? s->nb_rows : s->nb_cols;
+  if (s->wrapping) return width <= FRONTIER_MAX_WIDTH_WRAP;
+  return width <= FRONTIER_MAX_WIDTH;
+}
+
+/* ************************************************************************** */
+
+uint64_t _solver_count_frontier(const solver* s) {
+  assert(s);
+  // sweep along the longer side, the frontier follows the shorter one
+  bool transposed = s->nb_rows < s->nb_cols;
+  uint nb_rows = transposed ? s->nb_cols : s->nb_rows;
+  uint w = transposed ? s->nb_rows : s->nb_cols;
+  bool wrapping = s->wrapping;
+  uint left = w, top = w + 1, anchor = 2 * w + 1;
+  uint nb_slots = wrapping ? 2 * w + 2 : w + 1;
+  assert(nb_slots <= MAX_SLOTS);
+  if (s->nb_cells == 0) return 1;
+
+  fmap cur, next;
+  _fmap_init(&cur, 1024);
+  _fmap_init(&next, 1024);
+
+  // initial states: the plugs entering row 0 from the last row
+  fstate st;
+  for (uint mask = 0; mask < (wrapping ? 1u << w : 1u); mask++) {
+    st.nb_slots = nb_slots;
+    st.done = false;
+    for (uint k = 0; k < nb_slots; k++) st.lab[k] = 0;
+    for (uint j = 0; j < w; j++)
+      if (mask & (1 << j)) st.lab[j] = st.lab[top + j] = _fstate_fresh(&st);
+    _fmap_add(&cur, _fstate_pack(&st), 1);
+  }
+
+  for (uint i = 0; i < nb_rows; i++) {
+    // row start: the plug entering column 0 from the last column
+    if (wrapping) {
+      for (uint k = 0; k < cur.capacity; k++) {
+        if (cur.keys[k] == NO_KEY) continue;
+        _fstate_unpack(cur.keys[k], nb_slots, &st);
+        _fmap_add(&next, _fstate_pack(&st), cur.vals[k]);
+        st.lab[left] = st.lab[anchor] = _fstate_fresh(&st);
+        _fmap_add(&next, _fstate_pack(&st), cur.vals[k]);
+      }
+      fmap tmp = cur;
+      cur = next;
+      next = tmp;
+      _fmap_clear(&next);
+    }
+
+    for (uint j = 0; j < w; j++) {
+      uint c = transposed ? j * s->nb_cols + i : i * s->nb_cols + j;
+      uint sh = s->shapes[c];
+      uint codes[NB_DIRS], nb_codes = 0;
+      for (uint k = 0; k < s->nb_orients[sh]; k++) {
+        uint code = _code[sh][s->orients[sh][k]];
+        if (transposed) code = _transpose_code(code);
+        // no half-edge may leave the grid
+        if (!wrapping && j == w - 1 && (code & DIR_MASK(EAST))) continue;
+        if (!wrapping && i == nb_rows - 1 && (code & DIR_MASK(SOUTH))) continue;
+        codes[nb_codes++] = code;
+      }
+
+      for (uint k = 0; k < cur.capacity; k++) {
+        if (cur.keys[k] == NO_KEY) continue;
+        fstate from;
+        _fstate_unpack(cur.keys[k], nb_slots, &from);
+        uint up = from.lab[j], lt = from.lab[left];
+        if (sh == EMPTY) {
+          if (up == 0 && lt == 0) _fmap_add(&next, cur.keys[k], cur.vals[k]);
+          continue;
+        }
+        if (from.done) continue;  // a piece outside the closed component
+
+        for (uint q = 0; q < nb_codes; q++) {
+          uint code = codes[q];
+          if (((code & DIR_MASK(NORTH)) != 0) != (up != 0)) continue;
+          if (((code & DIR_MASK(WEST)) != 0) != (lt != 0)) continue;
+          st = from;
+          uint l = up;
+          if (lt != 0) {
+            if (l == 0)
+              l = lt;
+            else if (lt != l)
+              _fstate_merge(&st, lt, l);
+          }
+          if (l == 0) l = _fstate_fresh(&st);
+          st.lab[j] = (code & DIR_MASK(SOUTH)) ? l : 0;
+          st.lab[left] = (code & DIR_MASK(EAST)) ? l : 0;
+          if (!_fstate_close(&st, l)) continue;
+          _fmap_add(&next, _fstate_pack(&st), cur.vals[k]);
+        }
+      }
+      fmap tmp = cur;
+      cur = next;
+      next = tmp;
+      _fmap_clear(&next);
+    }
+
+    // row end: join the plug leaving the last column with the anchor
+    if (wrapping) {
+      for (uint k = 0; k < cur.capacity; k++) {
+        if (cur.keys[k] == NO_KEY) continue;
+        _fstate_unpack(cur.keys[k], nb_slots, &st);
+        if (!_fstate_end_row(&st, left, anchor)) continue;
+        _fmap_add(&next, _fstate_pack(&st), cur.vals[k]);
+      }
+      fmap tmp = cur;
+      cur = next;
+      next = tmp;
+      _fmap_clear(&next);
+    }
+  }
+
+  // end: join the plugs leaving the last row with those entering row 0
+  uint64_t nb_solutions = 0;
+  for (uint k = 0; k < cur.capacity; k++) {
+    if (cur.keys[k] == NO_KEY) continue;
+    _fstate_unpack(cur.keys[k], nb_slots, &st);
+    if (_fstate_accept(&st, w, top, wrapping)) nb_solutions += cur.vals[k];
+  }
+
+  _fmap_free(&cur);
+  _fmap_free(&next);
+  return nb_solutions;
+}
+
+/* ************************************************************************** */
+
+solver_zdd* _solver_compile_frontier(const solver* s) {
+  assert(s);
+  bool transposed = s->nb_rows < s->nb_cols;
+  uint nb_rows = transposed ? s->nb_cols : s->nb_rows;
+  uint w = transposed ? s->nb_rows : s->nb_cols;
+  bool wrapping = s->wrapping;
+  uint left = w, top = w + 1, anchor = 2 * w + 1;
+  uint nb_slots = wrapping ? 2 * w + 2 : w + 1;
+  assert(nb_slots <= MAX_SLOTS);
+  uint n = s->nb_cells;
+  solver_zdd* z = _solver_zdd_new(s);
+  if (n == 0) {
+    z->root = 1;
+    _solver_zdd_reduce(z);
+    return z;
+  }
+
+  fmap cur, next;
+  _fmap_init(&cur, 1024);
+  _fmap_init(&next, 1024);
+
+  // a single initial state: the plugs crossing the border of a wrapping grid
+  // are given by the orientations of the first row and of the first column
+  fstate st;
+  st.nb_slots = nb_slots;
+  st.done = false;
+  for (uint k = 0; k < nb_slots; k++) st.lab[k] = 0;
+  z->root = _solver_zdd_add_node(z);
+  _fmap_get(&cur, _fstate_pack(&st), z->root);
+
+  for (uint i = 0, t = 0; i < nb_rows; i++) {
+    for (uint j = 0; j < w; j++, t++) {
+      uint c = transposed ? j * s->nb_cols + i : i * s->nb_cols + j;
+      uint sh = s->shapes[c];
+      z->cells[t] = c;
+      z->level_start[t + 1] = z->nb_nodes;
+      uint codes[NB_DIRS], dirs[NB_DIRS], nb_codes = 0;
+      for (uint k = 0; k < s->nb_orients[sh]; k++) {
+        uint code = _code[sh][s->orients[sh][k]];
+        if (transposed) code = _transpose_code(code);
+        if (!wrapping && j == w - 1 && (code & DIR_MASK(EAST))) continue;
+        if (!wrapping && i == nb_rows - 1 && (code & DIR_MASK(SOUTH))) continue;
+        dirs[nb_codes] = s->orients[sh][k];
+        codes[nb_codes++] = code;
+      }
+      bool first_row = wrapping && i == 0, first_col = wrapping && j == 0;
+      bool last = (t == n - 1);
+
+      for (uint k = 0; k < cur.capacity; k++) {
+        if (cur.keys[k] == NO_KEY) continue;
+        uint id = (uint)cur.vals[k];
+        fstate from;
+        _fstate_unpack(cur.keys[k], nb_slots, &from);
+        uint up = from.lab[j], lt = from.lab[left];
+        for (uint q = 0; q < nb_codes; q++) {
+          uint code = codes[q];
+          bool north = (code & DIR_MASK(NORTH)) != 0;
+          bool west = (code & DIR_MASK(WEST)) != 0;
+          if (!first_row && north != (up != 0)) continue;
+          if (!first_col && west != (lt != 0)) continue;
+          st = from;
+          if (sh != EMPTY) {
+            if (from.done) continue;  // a piece outside the closed component
+            uint l = up;
+            if (lt != 0) {
+              if (l == 0)
+                l = lt;
+              else if (lt != l)
+                _fstate_merge(&st, lt, l);
+            }
+            if (l == 0) l = _fstate_fresh(&st);
+            if (first_row && north) st.lab[top + j] = l;
+            if (first_col && west) st.lab[anchor] = l;
+            st.lab[j] = (code & DIR_MASK(SOUTH)) ? l : 0;
+            st.lab[left] = (code & DIR_MASK(EAST)) ? l : 0;
+            if (!_fstate_close(&st, l)) continue;
+          }
+          if (wrapping && j == w - 1 && !_fstate_end_row(&st, left, anchor))
+            continue;
+
+          uint child;
+          if (last)
+            child = _fstate_accept(&st, w, top, wrapping) ? 1 : 0;
+          else {
+            child = (uint)_fmap_get(&next, _fstate_pack(&st), z->nb_nodes);
+            if (child == z->nb_nodes) _solver_zdd_add_node(z);
+          }
+          z->child[id * NB_DIRS + dirs[q]] = child;
+        }
+      }
+      fmap tmp = cur;
+      cur = next;
+      next = tmp;
+      _fmap_clear(&next);
+    }
+  }
+  z->level_start[n] = z->nb_nodes;
+
+  _fmap_free(&cur);
+  _fmap_free(&next);
+  _solver_zdd_reduce(z);
+  return z;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,481 @@
+/**
+ * @file game_solver_local.c
+ * @brief Anytime local search for the very large games.
+ * @details On grids of hundreds of thousands of squares, a complete search
+ * cannot be run in a reasonable time, even on games generated solvable. The
+ * local search starts from the current orientations, within the domains
+ * left by the propagation at the root (which fixes most of the squares of a
+ * large game), and works in two phases:
+ *  - simulated annealing on the number of unmatched half-edges: a square
+ *    with an unmatched half-edge around it is drawn at random and turned to
+ *    another orientation of its domain, the move being kept if it does not
+ *    make the count worse, or else with a probability that decreases with
+ *    the temperature; only the edges of the square change, so a move is
+ *    evaluated in constant time, and the squares in conflict are kept in an
+ *    indexed set;
+ *  - repair: the pieces that are still in conflict, and the pieces of all
+ *    the components but the largest, are freed with the squares around them
+ *    (up to a radius, through the squares not fixed at the root) and solved
+ *    again with the complete search, all the other squares keeping their
+ *    orientation; the radius grows until the repair succeeds or the time
+ *    runs out, a repair that takes too many nodes being given up for a
+ *    larger one.
+ * The best state met is kept all along, through the log of the moves made
+ * since it, so the search can be stopped at any time.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+/** share of the time given to the annealing, the rest goes to the repair */
+#define LOCAL_ANNEALING_SHARE 0.7
+
+/** temperatures at the start and at the end of the annealing */
+#define LOCAL_T_START 0.6
+#define LOCAL_T_END 0.05
+
+/** largest change of the count made by a move */
+#define LOCAL_MAX_DELTA 8
+
+/** number of moves between two reads of the clock */
+#define LOCAL_CLOCK_PERIOD 1024
+
+/** search nodes allowed to a repair, per free square of its region */
+#define LOCAL_NODES_PER_SQUARE 64
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** state of the local search, on the orientations of the solver */
+typedef struct {
+  solver* s;
+  const unsigned char* doms; /**< orientations allowed for each square */
+  uint64_t rng;              /**< xorshift state */
+  uint nb_unmatched;         /**< unmatched half-edges of the current state */
+  uint* conflict;            /**< squares with an unmatched half-edge around */
+  uint* conflict_pos;        /**< index of a square in conflict (or NO_CELL) */
+  uint nb_conflict;          /**< number of squares in conflict */
+  uint best;                 /**< unmatched half-edges of the best state */
+  direction* best_dirs;      /**< the best state, once saved */
+  bool saved;                /**< is best_dirs the best state? */
+  uint* log_cell;            /**< otherwise, the moves made since it: the */
+  direction* log_dir;        /**< square and its previous orientation */
+  uint log_len;              /**< number of moves in the log */
+  double accept[LOCAL_MAX_DELTA + 1]; /**< probability of keeping a move that
+                                           makes the count worse by delta */
+} local;
+
+/* ************************************************************************** */
+/*                                 TOOLS                                      */
+/* ************************************************************************** */
+
+/* monotonic time, in seconds */
+static double _local_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* ************************************************************************** */
+
+static uint64_t _local_rand(local* l) {
+  l->rng ^= l->rng << 13;
+  l->rng ^= l->rng >> 7;
+  l->rng ^= l->rng << 17;
+  return l->rng;
+}
+
+/* ************************************************************************** */
+
+/* set the orientation of square c */
+static void _local_set(solver* s, uint c, direction o) {
+  s->dirs[c] = o;
+  s->codes[c] = _code[s->shapes[c]][o];
+}
+
+/* ************************************************************************** */
+/*                            UNMATCHED EDGES                                 */
+/* ************************************************************************** */
+
+/* has square c a half-edge in direction d with none facing it? */
+static uint _local_unmatched(const solver* s, uint c, direction d) {
+  if (!(s->codes[c] & DIR_MASK(d))) return 0;
+  uint next = s->adj[NB_DIRS * c + d];
+  return next == NO_CELL || !(s->codes[next] & DIR_MASK((d + 2) % NB_DIRS));
+}
+
+/* ************************************************************************** */
+
+/* unmatched half-edges of square c and those of its neighbours facing it */
+static uint _local_cost(const solver* s, uint c) {
+  uint cost = 0;
+  for (direction d = 0; d < NB_DIRS; d++) {
+    uint next = s->adj[NB_DIRS * c + d];
+    cost += _local_unmatched(s, c, d);
+    if (next != NO_CELL && next != c)
+      cost += _local_unmatched(s, next, (d + 2) % NB_DIRS);
+  }
+  return cost;
+}
+
+/* ************************************************************************** */
+
+/* add square c to the squares in conflict, or remove it, in constant time */
+static void _local_set_conflict(local* l, uint c, bool conflict) {
+  if (conflict == (l->conflict_pos[c] != NO_CELL)) return;
+  if (conflict) {
+    l->conflict_pos[c] = l->nb_conflict;
+    l->conflict[l->nb_conflict++] = c;
+  } else {
+    uint last = l->conflict[--l->nb_conflict];
+    l->conflict[l->conflict_pos[c]] = last;
+    l->conflict_pos[last] = l->conflict_pos[c];
+    l->conflict_pos[c] = NO_CELL;
+  }
+}
+
+/* ************************************************************************** */
+
+/* is square c in conflict, and can it be turned? */
+static bool _local_movable(const local* l, uint c) {
+  uint dom = l->doms[c];
+  return (dom & (dom - 1)) != 0 && _local_cost(l->s, c) > 0;
+}
+
+/* ************************************************************************** */
+
+/* square c changed: update it and its neighbours in the conflict set */
+static void _local_update_conflicts(local* l, uint c) {
+  solver* s = l->s;
+  _local_set_conflict(l, c, _local_movable(l, c));
+  for (direction d = 0; d < NB_DIRS; d++) {
+    uint next = s->adj[NB_DIRS * c + d];
+    if (next != NO_CELL) _local_set_conflict(l, next, _local_movable(l, next));
+  }
+}
+
+/* ************************************************************************** */
+/*                               BEST STATE                                   */
+/* ************************************************************************** */
+
+/* a move of square c from orientation old was kept */
+static void _local_log(local* l, uint c, direction old) {
+  solver* s = l->s;
+  if (l->nb_unmatched < l->best) {
+    // the current state is the best one, nothing to undo
+    l->best = l->nb_unmatched;
+    l->saved = false;
+    l->log_len = 0;
+    return;
+  }
+  if (l->saved) return;
+  l->log_cell[l->log_len] = c;
+  l->log_dir[l->log_len++] = old;
+  if (l->log_len < s->nb_cells) return;
+  // the log is full: the best state is saved once and for all
+  memcpy(l->best_dirs, s->dirs, s->nb_cells * sizeof(direction));
+  while (l->log_len > 0) {
+    l->log_len--;
+    l->best_dirs[l->log_cell[l->log_len]] = l->log_dir[l->log_len];
+  }
+  l->saved = true;
+}
+
+/* ************************************************************************** */
+
+/* go back to the best state */
+static void _local_restore_best(local* l) {
+  solver* s = l->s;
+  if (l->saved) {
+    for (uint c = 0; c < s->nb_cells; c++) _local_set(s, c, l->best_dirs[c]);
+  } else {
+    while (l->log_len > 0) {
+      l->log_len--;
+      _local_set(s, l->log_cell[l->log_len], l->log_dir[l->log_len]);
+    }
+  }
+  l->saved = false;
+  l->nb_unmatched = l->best;
+}
+
+/* ************************************************************************** */
+/*                               ANNEALING                                    */
+/* ************************************************************************** */
+
+static void _local_set_temperature(local* l, double t) {
+  for (uint delta = 0; delta <= LOCAL_MAX_DELTA; delta++)
+    l->accept[delta] = exp(-(double)delta / t);
+}
+
+/* ************************************************************************** */
+
+/* one move: a square in conflict turned to another orientation */
+static void _local_move(local* l) {
+  solver* s = l->s;
+  uint c = l->conflict[_local_rand(l) % l->nb_conflict];
+  direction old = s->dirs[c], o;
+  do
+    o = _local_rand(l) % NB_DIRS;
+  while (!(l->doms[c] & (1 << o)) || _code[s->shapes[c]][o] == s->codes[c]);
+
+  int before = _local_cost(s, c);
+  _local_set(s, c, o);
+  int delta = (int)_local_cost(s, c) - before;
+  double x = (double)(_local_rand(l) >> 11) * 0x1p-53;  // in [0, 1)
+  if (delta > 0 && x >= l->accept[delta]) {
+    _local_set(s, c, old);
+    return;
+  }
+  l->nb_unmatched += delta;
+  _local_update_conflicts(l, c);
+  _local_log(l, c, old);
+}
+
+/* ************************************************************************** */
+
+/* anneal until no half-edge is unmatched, or until the deadline */
+static void _local_anneal(local* l, double deadline) {
+  double start = _local_now(), length = deadline - start;
+  uint64_t nb_moves = 0;
+  while (l->nb_conflict > 0) {
+    if (nb_moves++ % LOCAL_CLOCK_PERIOD == 0) {
+      double now = _local_now();
+      if (now >= deadline) break;
+      double x = (now - start) / length;
+      _local_set_temperature(l, LOCAL_T_START *
+                                    pow(LOCAL_T_END / LOCAL_T_START, x));
+    }
+    _local_move(l);
+  }
+}
+
+/* ************************************************************************** */
+/*                                 REPAIR                                     */
+/* ************************************************************************** */
+
+/* components of the network of the current state (through the matched
+ * edges): the squares of all of them but the largest one are added to seeds,
+ * returns the number of components */
+static uint _local_components(const solver* s, uint* seeds, uint* nb_seeds) {
+  uint n = s->nb_cells, nb_comps = 0, largest = NO_CELL, largest_size = 0;
+  uint* comp = (uint*)malloc(n * sizeof(uint));
+  uint* stack = (uint*)malloc(n * sizeof(uint));
+  assert(n == 0 || (comp && stack));
+  for (uint c = 0; c < n; c++) comp[c] = NO_CELL;
+  for (uint c = 0; c < n; c++) {
+    if (s->shapes[c] == EMPTY || comp[c] != NO_CELL) continue;
+    uint len = 0, size = 0;
+    comp[c] = nb_comps;
+    stack[len++] = c;
+    while (len > 0) {
+      uint x = stack[--len];
+      size++;
+      for (direction d = 0; d < NB_DIRS; d++) {
+        uint next = s->adj[NB_DIRS * x + d];
+        if (!(s->codes[x] & DIR_MASK(d)) || _local_unmatched(s, x, d) ||
+            comp[next] != NO_CELL)
+          continue;
+        comp[next] = nb_comps;
+        stack[len++] = next;
+      }
+    }
+    if (size > largest_size) {
+      largest_size = size;
+      largest = nb_comps;
+    }
+    nb_comps++;
+  }
+  for (uint c = 0; c < n; c++)
+    if (comp[c] != NO_CELL && comp[c] != largest) seeds[(*nb_seeds)++] = c;
+  free(comp);
+  free(stack);
+  return nb_comps;
+}
+
+/* ************************************************************************** */
+
+/* free the squares at distance at most r of the seeds, going only through the
+ * squares not fixed at the root: the others keep their orientation in any
+ * case, and do not pass on a change */
+static void _local_free_region(const solver* s, const solver* root,
+                               const uint* seeds, uint nb_seeds, uint r,
+                               bool* free_sq) {
+  uint n = s->nb_cells;
+  uint* dist = (uint*)malloc(n * sizeof(uint));
+  uint* queue = (uint*)malloc(n * sizeof(uint));
+  assert(n == 0 || (dist && queue));
+  uint head = 0, tail = 0;
+  for (uint c = 0; c < n; c++) dist[c] = NO_CELL;
+  for (uint k = 0; k < nb_seeds; k++)
+    if (dist[seeds[k]] == NO_CELL) {
+      dist[seeds[k]] = 0;
+      queue[tail++] = seeds[k];
+    }
+  while (head < tail) {
+    uint c = queue[head++];
+    free_sq[c] = true;
+    if (dist[c] == r) continue;
+    for (direction d = 0; d < NB_DIRS; d++) {
+      uint next = s->adj[NB_DIRS * c + d];
+      if (next == NO_CELL || dist[next] != NO_CELL || root->placed[next])
+        continue;
+      dist[next] = dist[c] + 1;
+      queue[tail++] = next;
+    }
+  }
+  free(dist);
+  free(queue);
+}
+
+/* ************************************************************************** */
+
+/* solve again the region of radius r around the seeds, from the root of the
+ * search (presolved and propagated), every other square of s keeping its
+ * orientation; returns true if solved, the reason of a stop being left in
+ * s->status */
+static bool _local_repair(solver* s, const solver* root, const uint* seeds,
+                          uint nb_seeds, uint r, double deadline) {
+  uint n = s->nb_cells;
+  bool* free_sq = (bool*)calloc(n, sizeof(bool));
+  assert(n == 0 || free_sq);
+  _local_free_region(s, root, seeds, nb_seeds, r, free_sq);
+
+  // the orientations of the state are tried first in the region, and a
+  // square that cannot keep its orientation is left free as well
+  solver* t = _solver_copy(root);
+  for (uint c = 0; c < n; c++) {
+    t->prefs[c] = s->dirs[c];
+    if (free_sq[c] || t->placed[c] || !(t->doms[c] & (1 << s->dirs[c])))
+      continue;
+    solver_mark m = _solver_mark(t);
+    if (!_solver_decide(t, c, s->dirs[c])) _solver_restore(t, m);
+  }
+  // only the squares left unfixed are scanned when branching, and a region
+  // whose search blows up is left for a larger one
+  if (!t->order) t->order = (uint*)malloc(n * sizeof(uint));
+  assert(n == 0 || t->order);
+  t->nb_order = 0;
+  for (uint c = 0; c < n; c++)
+    if (!t->placed[c]) t->order[t->nb_order++] = c;
+  t->limit = 1;
+  t->max_nodes = LOCAL_NODES_PER_SQUARE * (uint64_t)t->nb_order + 1;
+  t->nb_nodes = 0;
+  t->status = SOLVER_FINISHED;
+  t->deadline = deadline;
+  bool solved = _solver_count_subtree(t) > 0;
+  s->status = t->status;
+  if (solved) {
+    memcpy(s->dirs, t->dirs, n * sizeof(direction));
+    memcpy(s->codes, t->codes, n * sizeof(unsigned char));
+  }
+  _solver_delete(t);
+  free(free_sq);
+  return solved;
+}
+
+/* ************************************************************************** */
+/*                                ROUTINES                                    */
+/* ************************************************************************** */
+
+uint _solver_solve_local(solver* s, double time_limit) {
+  assert(s && s->trail_len == 0);
+  uint n = s->nb_cells;
+  double start = _local_now();
+  double deadline = start + time_limit;
+
+  // the domains left by the propagation at the root, or the whole domains
+  // of the shapes if the game has no solution
+  solver* root = _solver_copy(s);
+  presolve_report report;
+  bool solvable = _solver_presolve(root, &report) && _solver_init(root);
+  unsigned char* doms = (unsigned char*)malloc(n * sizeof(unsigned char));
+  assert(n == 0 || doms);
+  for (uint c = 0; c < n; c++) {
+    doms[c] = solvable ? root->doms[c] : s->domain[s->shapes[c]];
+    // the distinct orientation of the current code, or else the first one
+    // left in the domain
+    uint sh = s->shapes[c], o = 0;
+    while (_code[sh][o] != s->codes[c] || !(s->domain[sh] & (1 << o))) o++;
+    if (!(doms[c] & (1 << o)))
+      for (o = 0; !(doms[c] & (1 << o)); o++) continue;
+    _local_set(s, c, o);
+  }
+
+  local l;
+  l.s = s;
+  l.doms = doms;
+  l.rng = 0x9E3779B97F4A7C15ull ^ n;
+  l.conflict = (uint*)malloc(n * sizeof(uint));
+  l.conflict_pos = (uint*)malloc(n * sizeof(uint));
+  l.best_dirs = (direction*)malloc(n * sizeof(direction));
+  l.log_cell = (uint*)malloc(n * sizeof(uint));
+  l.log_dir = (direction*)malloc(n * sizeof(direction));
+  assert(n == 0 || (l.conflict && l.conflict_pos && l.best_dirs &&
+                    l.log_cell && l.log_dir));
+  l.nb_unmatched = 0;
+  l.nb_conflict = 0;
+  for (uint c = 0; c < n; c++) {
+    l.conflict_pos[c] = NO_CELL;
+    for (direction d = 0; d < NB_DIRS; d++)
+      l.nb_unmatched += _local_unmatched(s, c, d);
+  }
+  for (uint c = 0; c < n; c++)
+    _local_set_conflict(&l, c, _local_movable(&l, c));
+  l.best = l.nb_unmatched;
+  l.saved = false;
+  l.log_len = 0;
+
+  // annealing, then back to the best state met
+  _local_anneal(&l, start + LOCAL_ANNEALING_SHARE * time_limit);
+  _local_restore_best(&l);
+
+  // repair around the conflicts and the extra components, in a region whose
+  // radius grows by half each time (1, 2, 3, 5, 8, 12...)
+  uint* seeds = (uint*)malloc(2 * n * sizeof(uint));
+  assert(n == 0 || seeds);
+  uint nb_seeds = 0;
+  for (uint c = 0; c < n; c++)
+    if (_local_cost(s, c) > 0) seeds[nb_seeds++] = c;
+  uint nb_comps = _local_components(s, seeds, &nb_seeds);
+  s->status = SOLVER_FINISHED;
+  s->nb_solutions = (l.best == 0 && nb_comps <= 1);
+  for (uint r = 1; solvable && s->nb_solutions == 0; r += (r + 1) / 2) {
+    if (_local_now() >= deadline) {
+      s->status = SOLVER_TIMEOUT;
+      break;
+    }
+    if (_local_repair(s, root, seeds, nb_seeds, r, deadline)) {
+      l.best = 0;
+      s->nb_solutions = 1;
+    } else if (s->status == SOLVER_TIMEOUT || r >= n)
+      break;
+  }
+
+  _solver_delete(root);
+  free(doms);
+  free(seeds);
+  free(l.conflict);
+  free(l.conflict_pos);
+  free(l.best_dirs);
+  free(l.log_cell);
+  free(l.log_dir);
+  return l.best;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,216 @@
+/**
+ * @file game_solver_parallel.c
+ * @brief Parallel counting of the solutions.
+ * @details The search tree is split after a given number of decisions into
+ * independent tasks. The tasks are spread over the per-thread deques of a
+ * work-stealing pool: each worker pops the tasks of its own deque from the
+ * tail, and steals from the head of the other deques when its own is empty.
+ * Each worker owns a copy of the solver, so it never shares any search state
+ * with the others.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** deque of task indexes, protected by a lock */
+typedef struct {
+  pthread_mutex_t lock;
+  uint* tasks;
+  uint head; /**< next task to steal */
+  uint tail; /**< one past the next task to pop */
+} deque;
+
+/** the tasks, each one is a list of decisions from the root */
+typedef struct {
+  uint depth;          /**< maximal number of decisions in a task */
+  uint nb_tasks;       /**< number of tasks */
+  uint capacity;       /**< allocated number of tasks */
+  uint* lens;          /**< number of decisions of each task */
+  uint* cells;         /**< decided squares, depth entries per task */
+  unsigned char* dirs; /**< decided orientations, depth entries per task */
+  uint nb_workers;     /**< number of workers */
+  deque* deques;       /**< one deque per worker */
+} pool;
+
+/** a worker thread */
+typedef struct {
+  pool* p;
+  solver* s;         /**< private copy of the solver */
+  uint id;           /**< index of its own deque */
+  uint64_t nb_solutions; /**< solutions counted by this worker */
+} worker;
+
+/* ************************************************************************** */
+/*                                 TASKS                                      */
+/* ************************************************************************** */
+
+static void _pool_add(pool* p, const uint* cells, const unsigned char* dirs,
+                      uint len) {
+  if (p->nb_tasks == p->capacity) {
+    p->capacity = (p->capacity == 0) ? 64 : 2 * p->capacity;
+    p->lens = realloc(p->lens, p->capacity * sizeof(uint));
+    p->cells = realloc(p->cells, p->capacity * p->depth * sizeof(uint));
+    p->dirs = realloc(p->dirs, p->capacity * p->depth * sizeof(unsigned char));
+    assert(p->lens && p->cells && p->dirs);
+  }
+  uint t = p->nb_tasks++;
+  p->lens[t] = len;
+  for (uint k = 0; k < len; k++) {
+    p->cells[t * p->depth + k] = cells[k];
+    p->dirs[t * p->depth + k] = dirs[k];
+  }
+}
+
+/* ************************************************************************** */
+
+/* enumerate the consistent decisions up to the split depth, each branch left
+ * at this depth (or with all its pieces fixed) becomes a task */
+static void _pool_split(pool* p, solver* s, uint* cells, unsigned char* dirs,
+                        uint len) {
+  uint c = _solver_next_cell(s);
+  if (len == p->depth || c == NO_CELL) {
+    _pool_add(p, cells, dirs, len);
+    return;
+  }
+  uint dom = s->doms[c];
+  for (uint o = 0; o < NB_DIRS; o++) {
+    if (!(dom & (1 << o))) continue;
+    solver_mark m = _solver_mark(s);
+    if (_solver_decide(s, c, o)) {
+      cells[len] = c;
+      dirs[len] = o;
+      _pool_split(p, s, cells, dirs, len + 1);
+    }
+    _solver_restore(s, m);
+  }
+}
+
+/* ************************************************************************** */
+/*                              WORK STEALING                                 */
+/* ************************************************************************** */
+
+/* take a task from its own deque, or else steal one, returns false when
+ * there is no task left anywhere */
+static bool _pool_take(pool* p, uint id, uint* task) {
+  for (uint k = 0; k < p->nb_workers; k++) {
+    uint v = (id + k) % p->nb_workers;
+    deque* q = &p->deques[v];
+    bool found = false;
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+      // the owner works from the tail, the thieves from the head
+      *task = (v == id) ? q->tasks[--q->tail] : q->tasks[q->head++];
+      found = true;
+    }
+    pthread_mutex_unlock(&q->lock);
+    if (found) return true;
+  }
+  return false;
+}
+
+/* ************************************************************************** */
+
+static void* _worker_run(void* arg) {
+  worker* w = (worker*)arg;
+  pool* p = w->p;
+  uint t;
+  while (_pool_take(p, w->id, &t)) {
+    solver_mark m = _solver_mark(w->s);
+    bool ok = true;
+    for (uint k = 0; k < p->lens[t] && ok; k++)
+      ok = _solver_decide(w->s, p->cells[t * p->depth + k],
+                          p->dirs[t * p->depth + k]);
+    if (ok) w->nb_solutions += _solver_count_subtree(w->s);
+    _solver_restore(w->s, m);
+  }
+  return NULL;
+}
+
+/* ************************************************************************** */
+
+uint64_t _solver_count_parallel(solver* s, uint nb_threads, uint depth) {
+  assert(s);
+  if (nb_threads == 0) {
+    long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    nb_threads = (nb_cpus > 0) ? nb_cpus : 1;
+  }
+  if (!_solver_init(s)) return 0;
+  if (nb_threads == 1 || depth == 0) return _solver_count_subtree(s);
+
+  // split the search tree into tasks
+  pool p = {depth, 0, 0, NULL, NULL, NULL, nb_threads, NULL};
+  uint* cells = (uint*)malloc(depth * sizeof(uint));
+  unsigned char* dirs = (unsigned char*)malloc(depth * sizeof(unsigned char));
+  assert(cells && dirs);
+  _pool_split(&p, s, cells, dirs, 0);
+  free(cells);
+  free(dirs);
+
+  // spread them over the deques, neighbour subtrees to different workers
+  p.deques = (deque*)malloc(nb_threads * sizeof(deque));
+  assert(p.deques);
+  for (uint id = 0; id < nb_threads; id++) {
+    deque* q = &p.deques[id];
+    pthread_mutex_init(&q->lock, NULL);
+    q->tasks = (uint*)malloc((p.nb_tasks / nb_threads + 1) * sizeof(uint));
+    assert(q->tasks);
+    q->head = q->tail = 0;
+  }
+  for (uint t = 0; t < p.nb_tasks; t++) {
+    deque* q = &p.deques[t % nb_threads];
+    q->tasks[q->tail++] = t;
+  }
+
+  // the calling thread is worker 0, and works on the original solver
+  worker* workers = (worker*)malloc(nb_threads * sizeof(worker));
+  pthread_t* threads = (pthread_t*)malloc(nb_threads * sizeof(pthread_t));
+  assert(workers && threads);
+  for (uint id = 0; id < nb_threads; id++) {
+    workers[id].p = &p;
+    workers[id].s = (id == 0) ? s : _solver_copy(s);
+    workers[id].id = id;
+    workers[id].nb_solutions = 0;
+  }
+  for (uint id = 1; id < nb_threads; id++)
+    if (pthread_create(&threads[id], NULL, _worker_run, &workers[id]) != 0) {
+      fprintf(stderr, "Erreur : impossible de créer un thread\n");
+      exit(EXIT_FAILURE);
+    }
+  _worker_run(&workers[0]);
+
+  uint64_t nb_solutions = workers[0].nb_solutions;
+  for (uint id = 1; id < nb_threads; id++) {
+    pthread_join(threads[id], NULL);
+    nb_solutions += workers[id].nb_solutions;
+    _solver_delete(workers[id].s);
+  }
+
+  for (uint id = 0; id < nb_threads; id++) {
+    pthread_mutex_destroy(&p.deques[id].lock);
+    free(p.deques[id].tasks);
+  }
+  free(p.deques);
+  free(p.lens);
+  free(p.cells);
+  free(p.dirs);
+  free(workers);
+  free(threads);
+  s->nb_solutions = nb_solutions;
+  return nb_solutions;
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,133 @@
+/**
+ * @file game_solver_portfolio.c
+ * @brief Portfolio search: several configurations raced on threads.
+ * @details No search order wins on every game: plain row-major backtracking
+ * is the fastest on tiny grids, propagation on large and forced ones, the
+ * SAT backend on some dense ones, and an unlucky order of the squares or of
+ * the orientations can make any of them very slow. Each configuration works
+ * on its own copy of the solver; the first one to finish, with or without a
+ * solution, sets a shared flag that stops all the others.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "game_solver.h"
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** the race, shared by all the configurations */
+typedef struct {
+  pthread_mutex_t lock;
+  volatile bool stop; /**< set by the first configuration to finish */
+  int winner;         /**< index of that configuration (-1: none yet) */
+  bool solved;        /**< did it find a solution? */
+} race;
+
+/** a configuration of the search */
+typedef struct {
+  race* r;
+  solver* s; /**< private copy of the solver */
+  uint id;   /**< index of the configuration */
+} config;
+
+/* ************************************************************************** */
+/*                                 RACE                                       */
+/* ************************************************************************** */
+
+/* mode and orders of configuration id: the three modes first, then
+ * propagation with shuffled orders */
+static void _config_setup(solver* s, uint id) {
+  static const solver_mode modes[] = {SOLVER_PROPAGATE, SOLVER_BACKTRACK,
+                                      SOLVER_SAT};
+  s->mode = (id < 3) ? modes[id] : SOLVER_PROPAGATE;
+  if (id >= 3) _solver_set_seed(s, id);
+}
+
+/* ************************************************************************** */
+
+static void* _config_run(void* arg) {
+  config* cf = (config*)arg;
+  race* r = cf->r;
+  bool solved = _solver_solve(cf->s);
+  // a search that went through proves there is no solution, and also ends
+  // the race; the others only stopped because it ended
+  if (solved || cf->s->status == SOLVER_FINISHED) {
+    pthread_mutex_lock(&r->lock);
+    if (r->winner < 0) {
+      r->winner = cf->id;
+      r->solved = solved;
+      r->stop = true;
+    }
+    pthread_mutex_unlock(&r->lock);
+  }
+  return NULL;
+}
+
+/* ************************************************************************** */
+
+bool _solver_solve_portfolio(solver* s, uint nb_configs) {
+  assert(s);
+  if (nb_configs == 0) {
+    long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    nb_configs = (nb_cpus > 0) ? nb_cpus : 1;
+  }
+
+  race r;
+  pthread_mutex_init(&r.lock, NULL);
+  r.stop = false;
+  r.winner = -1;
+  r.solved = false;
+
+  // the calling thread runs the first configuration
+  config* configs = (config*)malloc(nb_configs * sizeof(config));
+  pthread_t* threads = (pthread_t*)malloc(nb_configs * sizeof(pthread_t));
+  assert(configs && threads);
+  for (uint id = 0; id < nb_configs; id++) {
+    solver* t = _solver_copy(s);
+    _config_setup(t, id);
+    t->cancel = &r.stop;
+    t->time_limit = s->time_limit;
+    t->max_nodes = s->max_nodes;
+    configs[id].r = &r;
+    configs[id].s = t;
+    configs[id].id = id;
+  }
+  for (uint id = 1; id < nb_configs; id++)
+    if (pthread_create(&threads[id], NULL, _config_run, &configs[id]) != 0) {
+      fprintf(stderr, "Erreur : impossible de créer un thread\n");
+      exit(EXIT_FAILURE);
+    }
+  _config_run(&configs[0]);
+  for (uint id = 1; id < nb_configs; id++) pthread_join(threads[id], NULL);
+
+  // the solution of the winner, or else why the race stopped
+  s->nb_solutions = 0;
+  s->status = SOLVER_FINISHED;
+  if (r.winner >= 0 && r.solved) {
+    const solver* w = configs[r.winner].s;
+    memcpy(s->dirs, w->dirs, s->nb_cells * sizeof(direction));
+    memcpy(s->codes, w->codes, s->nb_cells * sizeof(unsigned char));
+    s->nb_solutions = 1;
+  } else if (r.winner < 0)
+    s->status = configs[0].s->status;
+
+  for (uint id = 0; id < nb_configs; id++) _solver_delete(configs[id].s);
+  free(configs);
+  free(threads);
+  pthread_mutex_destroy(&r.lock);
+  return s->nb_solutions > 0;
+}
+
+/* ************************************************************************** */
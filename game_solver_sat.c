@@ -0,0 +1,254 @@
+/**
+ * @file game_solver_sat.c
+ * @brief SAT backend of the solver.
+ * @details The game is encoded as CNF clauses:
+ *  - one variable per square and distinct orientation, exactly one of them
+ *    being true for each square;
+ *  - one variable per edge between two adjacent squares, true when both
+ *    half-edges are present: each orientation forces the edges of its four
+ *    half-edges, so that half-edges always match (see has_half_edge in
+ *    game_aux.c), and those leaving the grid are forbidden.
+ * Connectivity is not encoded up-front. Each time the CDCL solver (see sat.h)
+ * returns a model whose pieces form several components, a cut clause is added
+ * for each component, asking for one of the edges leaving it, and the search
+ * goes on with the clauses learnt so far.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+#include "sat.h"
+
+/* ************************************************************************** */
+/*                                ENCODING                                    */
+/* ************************************************************************** */
+
+/** numbering of the CNF variables */
+typedef struct {
+  uint nb_vars;
+  uint* orient_var; /**< variable of the first orientation of each square */
+  uint* edge_var;   /**< edge_var[2*c]: east edge, edge_var[2*c+1]: south */
+} encoding;
+
+/** receives each clause of the encoding */
+typedef void (*clause_fn)(void* ctx, const int* lits, uint len);
+
+/* ************************************************************************** */
+
+static void _encoding_init(const solver* s, encoding* e) {
+  e->orient_var = (uint*)malloc(s->nb_cells * sizeof(uint));
+  e->edge_var = (uint*)malloc(2 * s->nb_cells * sizeof(uint));
+  assert(e->orient_var && e->edge_var);
+  e->nb_vars = 0;
+  for (uint c = 0; c < s->nb_cells; c++) {
+    e->orient_var[c] = e->nb_vars + 1;
+    e->nb_vars += s->nb_orients[s->shapes[c]];
+  }
+  for (uint c = 0; c < s->nb_cells; c++) {
+    e->edge_var[2 * c] =
+        (s->adj[NB_DIRS * c + EAST] != NO_CELL) ? ++e->nb_vars : 0;
+    e->edge_var[2 * c + 1] =
+        (s->adj[NB_DIRS * c + SOUTH] != NO_CELL) ? ++e->nb_vars : 0;
+  }
+}
+
+/* ************************************************************************** */
+
+static void _encoding_free(encoding* e) {
+  free(e->orient_var);
+  free(e->edge_var);
+}
+
+/* ************************************************************************** */
+
+/* variable of the edge carrying the half-edge of square c in direction d, or
+ * 0 if it leaves the grid */
+static uint _edge_var(const solver* s, const encoding* e, uint c, direction d) {
+  if (d == EAST || d == SOUTH) return e->edge_var[2 * c + (d == SOUTH)];
+  uint next = s->adj[NB_DIRS * c + d];
+  if (next == NO_CELL) return 0;
+  return e->edge_var[2 * next + (d == NORTH)];
+}
+
+/* ************************************************************************** */
+
+/* emit the clauses of the encoding, returns their number */
+static uint _encode(const solver* s, const encoding* e, clause_fn emit,
+                    void* ctx) {
+  uint nb_clauses = 0;
+  int lits[NB_DIRS];
+  for (uint c = 0; c < s->nb_cells; c++) {
+    uint sh = s->shapes[c], n = s->nb_orients[sh];
+    int first = e->orient_var[c];
+    // exactly one orientation
+    for (uint k = 0; k < n; k++) lits[k] = first + k;
+    emit(ctx, lits, n);
+    nb_clauses++;
+    for (uint k = 0; k < n; k++)
+      for (uint q = k + 1; q < n; q++) {
+        lits[0] = -(first + k);
+        lits[1] = -(first + q);
+        emit(ctx, lits, 2);
+        nb_clauses++;
+      }
+    // each orientation fixes the edges of its half-edges
+    for (uint k = 0; k < n; k++) {
+      uint code = _code[sh][s->orients[sh][k]];
+      for (direction d = 0; d < NB_DIRS; d++) {
+        int edge = _edge_var(s, e, c, d);
+        bool he = (code & DIR_MASK(d)) != 0;
+        if (edge == 0 && !he) continue;
+        lits[0] = -(first + k);
+        if (edge != 0) lits[1] = he ? edge : -edge;
+        emit(ctx, lits, (edge != 0) ? 2 : 1);
+        nb_clauses++;
+      }
+    }
+  }
+  return nb_clauses;
+}
+
+/* ************************************************************************** */
+/*                               SAT SEARCH                                   */
+/* ************************************************************************** */
+
+static void _emit_sat(void* ctx, const int* lits, uint len) {
+  sat_add_clause((sat*)ctx, lits, len);
+}
+
+/* ************************************************************************** */
+
+static uint _find(uint* parent, uint c) {
+  while (parent[c] != c) c = parent[c] = parent[parent[c]];
+  return c;
+}
+
+/* ************************************************************************** */
+
+/* read the model back into the solver, and add a cut for each component if
+ * the pieces are not connected, returns true if the model is a solution */
+static bool _read_model(solver* s, const encoding* e, sat* cnf, uint* parent,
+                        int* cut) {
+  for (uint c = 0; c < s->nb_cells; c++) {
+    uint sh = s->shapes[c];
+    uint k = 0;
+    while (k + 1 < s->nb_orients[sh] && !sat_value(cnf, e->orient_var[c] + k))
+      k++;
+    s->dirs[c] = s->orients[sh][k];
+    s->codes[c] = _code[sh][s->dirs[c]];
+    parent[c] = c;
+  }
+  for (uint c = 0; c < s->nb_cells; c++)
+    for (direction d = EAST; d <= SOUTH; d++)
+      if (s->codes[c] & DIR_MASK(d))
+        parent[_find(parent, c)] = _find(parent, s->adj[NB_DIRS * c + d]);
+
+  uint root = _find(parent, s->first_piece);
+  bool connected = true;
+  for (uint c = 0; c < s->nb_cells && connected; c++)
+    if (s->shapes[c] != EMPTY && _find(parent, c) != root) connected = false;
+  if (connected) return true;
+
+  // one cut per component: some edge must leave it
+  for (uint r = 0; r < s->nb_cells; r++) {
+    if (s->shapes[r] == EMPTY || _find(parent, r) != r) continue;
+    uint len = 0;
+    for (uint c = 0; c < s->nb_cells; c++) {
+      if (s->shapes[c] == EMPTY || _find(parent, c) != r) continue;
+      for (direction d = 0; d < NB_DIRS; d++) {
+        uint next = s->adj[NB_DIRS * c + d];
+        if (next == NO_CELL || s->shapes[next] == EMPTY) continue;
+        if (_find(parent, next) != r) cut[len++] = _edge_var(s, e, c, d);
+      }
+    }
+    sat_add_clause(cnf, cut, len);
+  }
+  return false;
+}
+
+/* ************************************************************************** */
+
+bool _solver_solve_sat(solver* s) {
+  assert(s);
+  s->nb_solutions = 0;
+  if (s->nb_pieces == 0) {
+    for (uint c = 0; c < s->nb_cells; c++) s->codes[c] = 0;
+    s->nb_solutions = 1;
+    return true;
+  }
+  encoding e;
+  _encoding_init(s, &e);
+  sat* cnf = sat_new(e.nb_vars);
+  _encode(s, &e, _emit_sat, cnf);
+
+  uint* parent = (uint*)malloc(s->nb_cells * sizeof(uint));
+  int* cut = (int*)malloc(NB_DIRS * s->nb_cells * sizeof(int));
+  assert(parent && cut);
+  bool solved = false;
+  sat_result result;
+  sat_set_interrupt(cnf, s->cancel);
+  while (!solved && (result = sat_solve(cnf)) == SAT_SAT)
+    solved = _read_model(s, &e, cnf, parent, cut);
+  if (!solved && result == SAT_UNKNOWN) s->status = SOLVER_CANCELLED;
+
+  free(parent);
+  free(cut);
+  sat_delete(cnf);
+  _encoding_free(&e);
+  if (solved) s->nb_solutions = 1;
+  return solved;
+}
+
+/* ************************************************************************** */
+/*                              DIMACS EXPORT                                 */
+/* ************************************************************************** */
+
+static void _emit_dimacs(void* ctx, const int* lits, uint len) {
+  FILE* f = (FILE*)ctx;
+  for (uint k = 0; k < len; k++) fprintf(f, "%d ", lits[k]);
+  fprintf(f, "0\n");
+}
+
+/* ************************************************************************** */
+
+static void _emit_none(void* ctx, const int* lits, uint len) {
+  (void)ctx;
+  (void)lits;
+  (void)len;
+}
+
+/* ************************************************************************** */
+
+void _solver_export_dimacs(const solver* s, FILE* f) {
+  assert(s && f);
+  static const char* dir_names[NB_DIRS] = {"N", "E", "S", "W"};
+  encoding e;
+  _encoding_init(s, &e);
+  uint nb_clauses = _encode(s, &e, _emit_none, NULL);
+
+  fprintf(f, "c net game %ux%u%s\n", s->nb_rows, s->nb_cols,
+          s->wrapping ? " wrapping" : "");
+  fprintf(f, "c connectivity of the pieces is not encoded, it must be\n");
+  fprintf(f, "c checked on the models (and refined with cut clauses)\n");
+  for (uint c = 0; c < s->nb_cells; c++) {
+    uint sh = s->shapes[c];
+    for (uint k = 0; k < s->nb_orients[sh]; k++)
+      fprintf(f, "c %u = square %u %u orientation %s\n", e.orient_var[c] + k,
+              c / s->nb_cols, c % s->nb_cols, dir_names[s->orients[sh][k]]);
+    for (direction d = EAST; d <= SOUTH; d++)
+      if (e.edge_var[2 * c + (d == SOUTH)] != 0)
+        fprintf(f, "c %u = edge %u %u %s\n", e.edge_var[2 * c + (d == SOUTH)],
+                c / s->nb_cols, c % s->nb_cols, dir_names[d]);
+  }
+  fprintf(f, "p cnf %u %u\n", e.nb_vars, nb_clauses);
+  _encode(s, &e, _emit_dimacs, f);
+  _encoding_free(&e);
+}
+
+/* ************************************************************************** */
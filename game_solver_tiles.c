@@ -0,0 +1,684 @@
+/**
+ * @file game_solver_tiles.c
+ * @brief Divide and conquer search: the grid is cut into rectangular tiles.
+ * @details Seen from outside, a way to fill a tile only matters through the
+ * half-edges leaving it (its signature, one bit per slot along its sides) and
+ * through the way its components join them (a label per slot). The search
+ * runs in three phases:
+ *  - each tile is filled in all the possible ways, on its own, the tiles
+ *    being spread over threads; the fillings are merged by signature and
+ *    labels into classes, each class keeping the orientations its fillings
+ *    use on each square. A component closed inside a tile is only allowed
+ *    if it holds all the pieces of the game, and a class whose components
+ *    are split further than those of another one with the same signature is
+ *    dropped (joining more is never worse for the whole network);
+ *  - the tiles are joined: neighbour tiles must agree on the half-edges of
+ *    their common side, the classes of a tile without a match next to it
+ *    being dropped until none is left (arc consistency on the sides);
+ *  - the search with propagation then runs on the whole grid, within the
+ *    orientations of the classes left, and checks the global connectivity.
+ * The classes of a tile only depend on its shapes and on the sides it shares
+ * with the grid border, so those of the last tiling are kept, and only the
+ * tiles whose shapes changed are filled again by the next search. A tile
+ * that can be filled in too many ways is left out of the join: its squares
+ * keep all their orientations.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+/** side of the tiles when none is given */
+#define TILE_SIZE 4
+
+/** largest side of a tile: the slots of its four sides fit in 64 bits */
+#define TILE_MAX_SIZE 16
+
+/** largest number of slots of a tile */
+#define TILE_SLOTS (4 * TILE_MAX_SIZE)
+
+/** search nodes allowed to fill a tile */
+#define TILE_MAX_NODES (1u << 24)
+
+/* ************************************************************************** */
+/*                             DATA TYPES                                     */
+/* ************************************************************************** */
+
+/** a rectangle of the grid, and the classes of its fillings; the slots are
+ * numbered along the north side, then the east, the south and the west
+ * sides */
+typedef struct {
+  uint i0, j0;           /**< its first square */
+  uint h, w;             /**< its size */
+  bool border[NB_DIRS];  /**< is the side on the grid border (no wrapping)? */
+  unsigned char* shapes; /**< its shapes, when the classes were computed */
+  uint nb_pieces;        /**< number of pieces in it */
+  bool filled;           /**< are the classes up to date? */
+  bool complete;         /**< were all the fillings enumerated? */
+  uint nb_classes;       /**< number of classes */
+  uint capacity;         /**< allocated number of classes */
+  uint64_t* sigs;        /**< signature of each class */
+  unsigned char* labels; /**< label of each slot (0: no half-edge), 2(h+w)
+                              per class */
+  unsigned char* orients; /**< orientations used by the fillings of each
+                               class on each square, h*w per class */
+  uint* index;           /**< hash table of the classes, while filling */
+  uint index_cap;        /**< its capacity, a power of 2 */
+} tile;
+
+/** the tiles of a grid */
+typedef struct {
+  uint nb_rows, nb_cols; /**< size of the grid */
+  bool wrapping;         /**< wrapping option of the grid */
+  uint size;             /**< side of the tiles */
+  uint tile_rows;        /**< number of rows of tiles */
+  uint tile_cols;        /**< number of columns of tiles */
+  tile* tiles;           /**< the tiles, in row-major order */
+} tiling;
+
+/** state of the enumeration of the fillings of a tile */
+typedef struct {
+  const solver* s;
+  tile* t;
+  direction* dirs;       /**< orientations of the current filling */
+  unsigned char* codes;  /**< their codes */
+  uint* uf;              /**< union-find on the squares of the tile */
+  uint* lab;             /**< label of the component of a root (0: none) */
+  unsigned char* labels; /**< labels of the slots of the current filling */
+  uint64_t nb_nodes;     /**< nodes of the enumeration so far */
+} filler;
+
+/** the tiles left to fill, shared by the threads */
+typedef struct {
+  pthread_mutex_t lock;
+  const solver* s;
+  tiling* g;
+  uint next; /**< next tile to look at */
+} fill_pool;
+
+/** state of the join of the tiles */
+typedef struct {
+  const tiling* g;
+  uint** doms;    /**< classes left for each tile, the first len[k] */
+  uint* len;      /**< number of classes left for each tile */
+  uint* queue;    /**< tiles whose classes changed, to propagate */
+  bool* queued;   /**< is the tile in the queue? */
+  uint64_t* seen; /**< side values met, one bit each */
+} join;
+
+/** the last tiling, whose classes are reused */
+static tiling _last = {0, 0, false, 0, 0, 0, NULL};
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ************************************************************************** */
+/*                                 TILES                                      */
+/* ************************************************************************** */
+
+static uint _tile_nb_slots(const tile* t) { return 2 * (t->h + t->w); }
+
+/* ************************************************************************** */
+
+/* first slot of side d of tile t, and its length */
+static uint _tile_side_start(const tile* t, direction d) {
+  switch (d) {
+    case NORTH:
+      return 0;
+    case EAST:
+      return t->w;
+    case SOUTH:
+      return t->w + t->h;
+    default:
+      return 2 * t->w + t->h;
+  }
+}
+
+static uint _tile_side_len(const tile* t, direction d) {
+  return (d == NORTH || d == SOUTH) ? t->w : t->h;
+}
+
+/* ************************************************************************** */
+
+/* half-edges of class k of tile t on side d, one bit per slot */
+static uint64_t _tile_side(const tile* t, uint k, direction d) {
+  uint64_t mask = ((uint64_t)1 << _tile_side_len(t, d)) - 1;
+  return (t->sigs[k] >> _tile_side_start(t, d)) & mask;
+}
+
+/* ************************************************************************** */
+
+/* forget the classes of tile t */
+static void _tile_clear(tile* t) {
+  free(t->sigs);
+  free(t->labels);
+  free(t->orients);
+  free(t->index);
+  t->sigs = NULL;
+  t->labels = NULL;
+  t->orients = NULL;
+  t->index = NULL;
+  t->nb_classes = t->capacity = t->index_cap = 0;
+  t->filled = t->complete = false;
+}
+
+/* ************************************************************************** */
+
+static uint64_t _tile_hash(uint64_t sig, const unsigned char* labels,
+                           uint nb_slots) {
+  uint64_t h = 14695981039346656037ULL ^ sig;
+  for (uint k = 0; k < nb_slots; k++) h = (h ^ labels[k]) * 1099511628211ULL;
+  return h ^ (h >> 29);
+}
+
+/* ************************************************************************** */
+
+/* add the class of the current filling of f, or add its orientations to
+ * those of its class if it is already known */
+static void _tile_add(filler* f, uint64_t sig) {
+  tile* t = f->t;
+  uint nb_slots = _tile_nb_slots(t), area = t->h * t->w;
+  if (2 * (t->nb_classes + 1) > t->index_cap) {
+    // grow the hash table, it holds class indexes plus one (0: free)
+    uint cap = (t->index_cap == 0) ? 64 : 2 * t->index_cap;
+    free(t->index);
+    t->index = (uint*)calloc(cap, sizeof(uint));
+    assert(t->index);
+    t->index_cap = cap;
+    for (uint k = 0; k < t->nb_classes; k++) {
+      uint x = _tile_hash(t->sigs[k], &t->labels[k * nb_slots], nb_slots) &
+               (cap - 1);
+      while (t->index[x]) x = (x + 1) & (cap - 1);
+      t->index[x] = k + 1;
+    }
+  }
+  uint x = _tile_hash(sig, f->labels, nb_slots) & (t->index_cap - 1);
+  for (; t->index[x]; x = (x + 1) & (t->index_cap - 1)) {
+    uint k = t->index[x] - 1;
+    if (t->sigs[k] == sig &&
+        memcmp(&t->labels[k * nb_slots], f->labels, nb_slots) == 0) {
+      for (uint y = 0; y < area; y++)
+        t->orients[k * area + y] |= 1 << f->dirs[y];
+      return;
+    }
+  }
+  if (t->nb_classes == t->capacity) {
+    t->capacity = (t->capacity == 0) ? 16 : 2 * t->capacity;
+    t->sigs = realloc(t->sigs, t->capacity * sizeof(uint64_t));
+    t->labels = realloc(t->labels, t->capacity * nb_slots);
+    t->orients = realloc(t->orients, t->capacity * area);
+    assert(t->sigs && t->labels && t->orients);
+  }
+  uint k = t->nb_classes++;
+  t->index[x] = k + 1;
+  t->sigs[k] = sig;
+  memcpy(&t->labels[k * nb_slots], f->labels, nb_slots);
+  for (uint y = 0; y < area; y++) t->orients[k * area + y] = 1 << f->dirs[y];
+}
+
+/* ************************************************************************** */
+/*                                 FILLING                                    */
+/* ************************************************************************** */
+
+static uint _filler_find(uint* uf, uint x) {
+  while (uf[x] != x) x = uf[x] = uf[uf[x]];
+  return x;
+}
+
+/* ************************************************************************** */
+
+/* the current filling of f is complete: find its components, and record its
+ * class if none of them is closed (unless it holds all the pieces) */
+static void _filler_leaf(filler* f) {
+  const tile* t = f->t;
+  uint h = t->h, w = t->w, area = h * w;
+  for (uint k = 0; k < area; k++) {
+    f->uf[k] = k;
+    f->lab[k] = 0;
+  }
+  for (uint k = 0; k < area; k++) {
+    if (k % w + 1 < w && (f->codes[k] & DIR_MASK(EAST)))
+      f->uf[_filler_find(f->uf, k)] = _filler_find(f->uf, k + 1);
+    if (k / w + 1 < h && (f->codes[k] & DIR_MASK(SOUTH)))
+      f->uf[_filler_find(f->uf, k)] = _filler_find(f->uf, k + w);
+  }
+
+  // the slots, and the labels of their components by order of appearance
+  uint64_t sig = 0;
+  uint nb_labels = 0;
+  for (direction d = 0; d < NB_DIRS; d++) {
+    uint start = _tile_side_start(t, d), len = _tile_side_len(t, d);
+    for (uint x = 0; x < len; x++) {
+      uint k = (d == NORTH)   ? x
+               : (d == EAST)  ? x * w + w - 1
+               : (d == SOUTH) ? (h - 1) * w + x
+                              : x * w;
+      f->labels[start + x] = 0;
+      if (!(f->codes[k] & DIR_MASK(d))) continue;
+      uint r = _filler_find(f->uf, k);
+      if (f->lab[r] == 0) f->lab[r] = ++nb_labels;
+      f->labels[start + x] = f->lab[r];
+      sig |= (uint64_t)1 << (start + x);
+    }
+  }
+
+  // pieces in a component without any slot: only allowed if they are all
+  // the pieces of the game, in a single component
+  uint nb_closed = 0, root = NO_CELL;
+  bool single = true;
+  for (uint k = 0; k < area; k++) {
+    uint c = (t->i0 + k / w) * f->s->nb_cols + t->j0 + k % w;
+    uint r = _filler_find(f->uf, k);
+    if (f->s->shapes[c] == EMPTY || f->lab[r] != 0) continue;
+    nb_closed++;
+    if (root == NO_CELL) root = r;
+    single = single && r == root;
+  }
+  if (nb_closed == 0 ||
+      (nb_labels == 0 && single && nb_closed == f->s->nb_pieces))
+    _tile_add(f, sig);
+}
+
+/* ************************************************************************** */
+
+/* enumerate the fillings of the squares k and after of the tile, in
+ * row-major order; returns false once out of nodes */
+static bool _filler_run(filler* f, uint k) {
+  const tile* t = f->t;
+  const solver* s = f->s;
+  uint w = t->w, area = t->h * w;
+  if (k == area) {
+    _filler_leaf(f);
+    return true;
+  }
+  if (++f->nb_nodes > TILE_MAX_NODES) return false;
+  uint a = k / w, b = k % w;
+  uint sh = s->shapes[(t->i0 + a) * s->nb_cols + t->j0 + b];
+  for (uint n = 0; n < s->nb_orients[sh]; n++) {
+    uint o = s->orients[sh][n], code = _code[sh][o];
+    // the half-edges must match those of the squares before it in the tile,
+    // and none may leave the grid
+    bool he_n = code & DIR_MASK(NORTH), he_w = code & DIR_MASK(WEST);
+    if (a > 0 ? he_n != ((f->codes[k - w] & DIR_MASK(SOUTH)) != 0)
+              : he_n && t->border[NORTH])
+      continue;
+    if (b > 0 ? he_w != ((f->codes[k - 1] & DIR_MASK(EAST)) != 0)
+              : he_w && t->border[WEST])
+      continue;
+    if (a + 1 == t->h && (code & DIR_MASK(SOUTH)) && t->border[SOUTH])
+      continue;
+    if (b + 1 == w && (code & DIR_MASK(EAST)) && t->border[EAST]) continue;
+    f->dirs[k] = o;
+    f->codes[k] = code;
+    if (!_filler_run(f, k + 1)) return false;
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* does partition a of the slots split any component of partition b? */
+static bool _tile_finer(const unsigned char* a, const unsigned char* b,
+                        uint nb_slots) {
+  unsigned char map[TILE_SLOTS + 1] = {0};
+  bool finer = false;
+  for (uint x = 0; x < nb_slots; x++) {
+    if (a[x] == 0) continue;
+    if (map[a[x]] == 0) map[a[x]] = b[x];
+    if (map[a[x]] != b[x]) return false;
+  }
+  // a is finer if two of its labels go to the same label of b
+  unsigned char seen[TILE_SLOTS + 1] = {0};
+  for (uint x = 1; x <= nb_slots; x++) {
+    if (map[x] == 0) continue;
+    finer = finer || seen[map[x]];
+    seen[map[x]] = 1;
+  }
+  return finer;
+}
+
+/* ************************************************************************** */
+
+static int _cmp_sig(const void* a, const void* b) {
+  uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* ************************************************************************** */
+
+/* drop the classes whose components are split further than those of
+ * another class with the same signature: joining more is never worse for the
+ * connectivity of the whole network */
+static void _tile_prune(tile* t) {
+  uint n = t->nb_classes, nb_slots = _tile_nb_slots(t), area = t->h * t->w;
+  if (n < 2) return;
+  // pairs (signature, class), sorted by signature
+  uint64_t* pairs = (uint64_t*)malloc(2 * n * sizeof(uint64_t));
+  bool* dropped = (bool*)calloc(n, sizeof(bool));
+  assert(pairs && dropped);
+  for (uint k = 0; k < n; k++) {
+    pairs[2 * k] = t->sigs[k];
+    pairs[2 * k + 1] = k;
+  }
+  qsort(pairs, n, 2 * sizeof(uint64_t), _cmp_sig);
+  for (uint x = 0; x < n;) {
+    uint y = x;
+    while (y < n && pairs[2 * y] == pairs[2 * x]) y++;
+    for (uint a = x; a < y; a++)
+      for (uint b = x; b < y && !dropped[pairs[2 * a + 1]]; b++) {
+        uint ka = pairs[2 * a + 1], kb = pairs[2 * b + 1];
+        if (a != b && !dropped[kb] &&
+            _tile_finer(&t->labels[ka * nb_slots], &t->labels[kb * nb_slots],
+                        nb_slots))
+          dropped[ka] = true;
+      }
+    x = y;
+  }
+  uint len = 0;
+  for (uint k = 0; k < n; k++) {
+    if (dropped[k]) continue;
+    t->sigs[len] = t->sigs[k];
+    memmove(&t->labels[len * nb_slots], &t->labels[k * nb_slots], nb_slots);
+    memmove(&t->orients[len * area], &t->orients[k * area], area);
+    len++;
+  }
+  t->nb_classes = len;
+  free(pairs);
+  free(dropped);
+}
+
+/* ************************************************************************** */
+
+/* compute the classes of tile t of the grid of s */
+static void _tile_fill(tile* t, const solver* s) {
+  uint area = t->h * t->w;
+  filler f = {s, t, NULL, NULL, NULL, NULL, NULL, 0};
+  f.dirs = (direction*)malloc(area * sizeof(direction));
+  f.codes = (unsigned char*)malloc(area);
+  f.uf = (uint*)malloc(area * sizeof(uint));
+  f.lab = (uint*)malloc(area * sizeof(uint));
+  f.labels = (unsigned char*)malloc(_tile_nb_slots(t));
+  assert(f.dirs && f.codes && f.uf && f.lab && f.labels);
+  t->complete = _filler_run(&f, 0);
+  t->filled = true;
+  _tile_prune(t);
+  // the hash table is only needed while filling
+  free(t->index);
+  t->index = NULL;
+  t->index_cap = 0;
+  t->nb_pieces = 0;
+  for (uint k = 0; k < area; k++) {
+    t->shapes[k] = s->shapes[(t->i0 + k / t->w) * s->nb_cols + t->j0 +
+                             k % t->w];
+    t->nb_pieces += t->shapes[k] != EMPTY;
+  }
+  free(f.dirs);
+  free(f.codes);
+  free(f.uf);
+  free(f.lab);
+  free(f.labels);
+}
+
+/* ************************************************************************** */
+
+static void* _fill_run(void* arg) {
+  fill_pool* p = (fill_pool*)arg;
+  uint nb_tiles = p->g->tile_rows * p->g->tile_cols;
+  while (true) {
+    pthread_mutex_lock(&p->lock);
+    while (p->next < nb_tiles && p->g->tiles[p->next].filled) p->next++;
+    uint k = p->next++;
+    pthread_mutex_unlock(&p->lock);
+    if (k >= nb_tiles) return NULL;
+    _tile_fill(&p->g->tiles[k], p->s);
+  }
+}
+
+/* ************************************************************************** */
+/*                                 TILING                                     */
+/* ************************************************************************** */
+
+static void _tiling_free(tiling* g) {
+  for (uint k = 0; k < g->tile_rows * g->tile_cols; k++) {
+    _tile_clear(&g->tiles[k]);
+    free(g->tiles[k].shapes);
+  }
+  free(g->tiles);
+  *g = (tiling){0, 0, false, 0, 0, 0, NULL};
+}
+
+/* ************************************************************************** */
+
+/* cut the grid of s into tiles of the given side (the last row and the last
+ * column of tiles take what is left), keeping the classes of the tiles whose
+ * shapes did not change since the last tiling */
+static void _tiling_update(tiling* g, const solver* s, uint size) {
+  if (g->nb_rows != s->nb_rows || g->nb_cols != s->nb_cols ||
+      g->wrapping != s->wrapping || g->size != size) {
+    _tiling_free(g);
+    g->nb_rows = s->nb_rows;
+    g->nb_cols = s->nb_cols;
+    g->wrapping = s->wrapping;
+    g->size = size;
+    g->tile_rows = (s->nb_rows + size - 1) / size;
+    g->tile_cols = (s->nb_cols + size - 1) / size;
+    g->tiles = (tile*)calloc(g->tile_rows * g->tile_cols, sizeof(tile));
+    assert(g->tiles);
+    for (uint ti = 0; ti < g->tile_rows; ti++)
+      for (uint tj = 0; tj < g->tile_cols; tj++) {
+        tile* t = &g->tiles[ti * g->tile_cols + tj];
+        t->i0 = ti * size;
+        t->j0 = tj * size;
+        t->h = (ti + 1 < g->tile_rows) ? size : s->nb_rows - t->i0;
+        t->w = (tj + 1 < g->tile_cols) ? size : s->nb_cols - t->j0;
+        t->border[NORTH] = !s->wrapping && ti == 0;
+        t->border[EAST] = !s->wrapping && tj + 1 == g->tile_cols;
+        t->border[SOUTH] = !s->wrapping && ti + 1 == g->tile_rows;
+        t->border[WEST] = !s->wrapping && tj == 0;
+        t->shapes = (unsigned char*)malloc(t->h * t->w);
+        assert(t->shapes);
+      }
+    return;
+  }
+  for (uint k = 0; k < g->tile_rows * g->tile_cols; k++) {
+    tile* t = &g->tiles[k];
+    bool same = t->filled;
+    for (uint x = 0; same && x < t->h * t->w; x++)
+      same = t->shapes[x] ==
+             s->shapes[(t->i0 + x / t->w) * s->nb_cols + t->j0 + x % t->w];
+    if (!same) _tile_clear(t);
+  }
+}
+
+/* ************************************************************************** */
+
+/* tile next to tile k in direction d, or NO_CELL */
+static uint _tiling_next(const tiling* g, uint k, direction d) {
+  uint ti = k / g->tile_cols, tj = k % g->tile_cols;
+  uint rows = g->tile_rows, cols = g->tile_cols;
+  bool border = (d == NORTH && ti == 0) || (d == SOUTH && ti + 1 == rows) ||
+                (d == WEST && tj == 0) || (d == EAST && tj + 1 == cols);
+  if (border && !g->wrapping) return NO_CELL;
+  if (d == NORTH) ti = (ti + rows - 1) % rows;
+  if (d == SOUTH) ti = (ti + 1) % rows;
+  if (d == WEST) tj = (tj + cols - 1) % cols;
+  if (d == EAST) tj = (tj + 1) % cols;
+  return ti * cols + tj;
+}
+
+/* ************************************************************************** */
+/*                                  JOIN                                      */
+/* ************************************************************************** */
+
+/* keep the classes of tile k whose side d matches a class left in the tile
+ * next to it, returns false if none is left */
+static bool _join_revise(join* j, uint k, direction d, bool* changed) {
+  const tiling* g = j->g;
+  uint next = _tiling_next(g, k, d);
+  const tile *t = &g->tiles[k], *u = &g->tiles[next];
+  direction back = (d + 2) % NB_DIRS;
+  for (uint x = 0; x < j->len[next]; x++) {
+    uint64_t v = _tile_side(u, j->doms[next][x], back);
+    j->seen[v >> 6] |= (uint64_t)1 << (v & 63);
+  }
+  uint* dom = j->doms[k];
+  uint n = j->len[k];
+  for (uint x = 0; x < n;) {
+    uint64_t v = _tile_side(t, dom[x], d);
+    if ((j->seen[v >> 6] >> (v & 63)) & 1)
+      x++;
+    else
+      dom[x] = dom[--n];
+  }
+  for (uint x = 0; x < j->len[next]; x++) {
+    uint64_t v = _tile_side(u, j->doms[next][x], back);
+    j->seen[v >> 6] = 0;
+  }
+  *changed = n < j->len[k];
+  j->len[k] = n;
+  return n > 0;
+}
+
+/* ************************************************************************** */
+
+/* propagate the changes of the tiles in the queue (all of them at first) to
+ * their neighbours, returns false if a tile is left without a class */
+static bool _join_propagate(join* j) {
+  uint nb_tiles = j->g->tile_rows * j->g->tile_cols;
+  uint head = 0, len = nb_tiles;
+  for (uint k = 0; k < nb_tiles; k++) {
+    j->queue[k] = k;
+    j->queued[k] = true;
+  }
+  // circular queue, each tile being at most once in it
+  while (len > 0) {
+    uint k = j->queue[head];
+    head = (head + 1) % nb_tiles;
+    len--;
+    j->queued[k] = false;
+    for (direction d = 0; d < NB_DIRS; d++) {
+      uint next = _tiling_next(j->g, k, d);
+      if (next == NO_CELL || !j->g->tiles[k].complete ||
+          !j->g->tiles[next].complete)
+        continue;
+      bool changed;
+      if (!_join_revise(j, next, (d + 2) % NB_DIRS, &changed)) return false;
+      if (changed && !j->queued[next]) {
+        j->queue[(head + len++) % nb_tiles] = next;
+        j->queued[next] = true;
+      }
+    }
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/*                                ROUTINES                                    */
+/* ************************************************************************** */
+
+bool _solver_solve_tiled(solver* s, uint tile_size, uint nb_threads) {
+  assert(s);
+  if (tile_size == 0) tile_size = TILE_SIZE;
+  if (tile_size > TILE_MAX_SIZE) tile_size = TILE_MAX_SIZE;
+  if (nb_threads == 0) {
+    long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    nb_threads = (nb_cpus > 0) ? nb_cpus : 1;
+  }
+  // a tile that would wrap onto itself is not handled: one tile in a
+  // direction is simply the whole grid
+  if (s->nb_rows <= tile_size || s->nb_cols <= tile_size)
+    return _solver_solve(s);
+
+  pthread_mutex_lock(&_lock);
+  tiling* g = &_last;
+  _tiling_update(g, s, tile_size);
+  uint nb_tiles = g->tile_rows * g->tile_cols;
+
+  // fill the tiles that changed, the calling thread being one of the workers
+  fill_pool p = {PTHREAD_MUTEX_INITIALIZER, s, g, 0};
+  uint nb_workers = (nb_threads < nb_tiles) ? nb_threads : nb_tiles;
+  pthread_t* threads = (pthread_t*)malloc(nb_workers * sizeof(pthread_t));
+  assert(threads);
+  for (uint id = 1; id < nb_workers; id++)
+    if (pthread_create(&threads[id], NULL, _fill_run, &p) != 0) {
+      fprintf(stderr, "Erreur : impossible de créer un thread\n");
+      exit(EXIT_FAILURE);
+    }
+  _fill_run(&p);
+  for (uint id = 1; id < nb_workers; id++) pthread_join(threads[id], NULL);
+  free(threads);
+  pthread_mutex_destroy(&p.lock);
+
+  // join the tiles
+  join j = {g, NULL, NULL, NULL, NULL, NULL};
+  j.doms = (uint**)malloc(nb_tiles * sizeof(uint*));
+  j.len = (uint*)malloc(nb_tiles * sizeof(uint));
+  j.queue = (uint*)malloc(nb_tiles * sizeof(uint));
+  j.queued = (bool*)malloc(nb_tiles * sizeof(bool));
+  j.seen = (uint64_t*)calloc(((uint64_t)1 << TILE_MAX_SIZE) / 64,
+                             sizeof(uint64_t));
+  assert(j.doms && j.len && j.queue && j.queued && j.seen);
+  bool ok = true;
+  for (uint k = 0; k < nb_tiles; k++) {
+    const tile* t = &g->tiles[k];
+    j.doms[k] = (uint*)malloc((t->nb_classes + 1) * sizeof(uint));
+    assert(j.doms[k]);
+    for (uint x = 0; x < t->nb_classes; x++) j.doms[k][x] = x;
+    j.len[k] = t->nb_classes;
+    ok = ok && (j.len[k] > 0 || !t->complete);
+  }
+  ok = ok && _join_propagate(&j);
+
+  // search the whole grid, within the orientations of the classes left
+  s->limit = 1;
+  s->nb_nodes = 0;
+  s->status = SOLVER_FINISHED;
+  s->deadline = 0;
+  s->nb_solutions = 0;
+  ok = ok && _solver_init(s);
+  for (uint k = 0; k < nb_tiles && ok; k++) {
+    const tile* t = &g->tiles[k];
+    uint area = t->h * t->w;
+    for (uint x = 0; x < area && ok && t->complete; x++) {
+      uint dom = 0;
+      for (uint y = 0; y < j.len[k]; y++)
+        dom |= t->orients[j.doms[k][y] * area + x];
+      uint c = (t->i0 + x / t->w) * s->nb_cols + t->j0 + x % t->w;
+      ok = _solver_narrow(s, c, dom);
+    }
+  }
+  pthread_mutex_unlock(&_lock);
+  bool solved = ok && _solver_count_subtree(s) > 0;
+
+  for (uint k = 0; k < nb_tiles; k++) free(j.doms[k]);
+  free(j.doms);
+  free(j.len);
+  free(j.queue);
+  free(j.queued);
+  free(j.seen);
+  return solved;
+}
+
+/* ************************************************************************** */
+
+void _solver_tiles_clear(void) {
+  pthread_mutex_lock(&_lock);
+  _tiling_free(&_last);
+  pthread_mutex_unlock(&_lock);
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,305 @@
+/**
+ * @file game_solver_warm.c
+ * @brief Solver state kept with a game between two solves.
+ * @details Rotating a piece never changes the constraints of the game: its
+ * solutions, the root domains and the result of probing only depend on the
+ * shapes. The first solve (or hint) of a game therefore leaves with it the
+ * solver at the root of its search, and the solution once it is found. The
+ * search is only run when needed: a hint is first looked for among the
+ * squares fixed by the root propagation, then among those left with a single
+ * orientation by probing. A move, an undo or a redo only changes the
+ * orientation of one square, so only what is known about that square and its
+ * four neighbours is updated:
+ *  - whether its code differs from the solution (the set of wrong squares);
+ *  - the number of mismatched half-edges of the game around it.
+ * The next solve only turns the wrong squares, and the next hint picks one
+ * of them, both in time proportional to the squares changed since. Changing
+ * a shape drops the whole state.
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+
+/** nodes of the search run by a hint when the root gives nothing */
+#define WARM_HINT_NODES 100000
+
+/* ************************************************************************** */
+/*                            MISMATCHED EDGES                                */
+/* ************************************************************************** */
+
+/* is the half-edge of square c in direction d unmatched in the game? */
+static uint _warm_mismatch(const solver_warm* w, uint c, direction d) {
+  uint next = w->s->adj[NB_DIRS * c + d];
+  bool here = w->cur[c] & DIR_MASK(d);
+  bool there =
+      next != NO_CELL && (w->cur[next] & DIR_MASK((d + 2) % NB_DIRS));
+  return here != there;
+}
+
+/* ************************************************************************** */
+
+/* unmatched half-edges of square c and those of its neighbours facing it (on
+ * a wrapping grid one square wide, the square faces itself) */
+static uint _warm_mismatch_around(const solver_warm* w, uint c) {
+  uint nb = 0;
+  for (direction d = 0; d < NB_DIRS; d++) {
+    nb += _warm_mismatch(w, c, d);
+    uint next = w->s->adj[NB_DIRS * c + d];
+    if (next != NO_CELL && next != c)
+      nb += _warm_mismatch(w, next, (d + 2) % NB_DIRS);
+  }
+  return nb;
+}
+
+/* ************************************************************************** */
+/*                             WRONG SQUARES                                  */
+/* ************************************************************************** */
+
+/* add square c to the wrong squares, or remove it, in constant time */
+static void _warm_set_wrong(solver_warm* w, uint c, bool wrong) {
+  if (wrong == (w->wrong_pos[c] != NO_CELL)) return;
+  if (wrong) {
+    w->wrong_pos[c] = w->nb_wrong;
+    w->wrong[w->nb_wrong++] = c;
+  } else {
+    uint last = w->wrong[--w->nb_wrong];
+    w->wrong[w->wrong_pos[c]] = last;
+    w->wrong_pos[last] = w->wrong_pos[c];
+    w->wrong_pos[c] = NO_CELL;
+  }
+}
+
+/* ************************************************************************** */
+
+/* probing at the root: the number of orientations of square c that resist
+ * propagation, the last of them in left */
+static uint _warm_probe(solver_warm* w, uint c, uint* left) {
+  solver* s = w->s;
+  solver_mark root = _solver_mark(s);
+  uint nb_left = 0;
+  for (uint k = 0; k < NB_DIRS; k++) {
+    if (!(s->doms[c] & (1 << k))) continue;
+    if (_solver_decide(s, c, k)) {
+      nb_left++;
+      *left = k;
+    }
+    _solver_restore(s, root);
+  }
+  return nb_left;
+}
+
+/* ************************************************************************** */
+
+/* probing at the root: is a single orientation of square c left once each of
+ * them is tried and propagated? */
+static bool _warm_forced(solver_warm* w, uint c) {
+  uint left;
+  if (w->forced[c] < 0) w->forced[c] = (_warm_probe(w, c, &left) == 1);
+  return w->forced[c];
+}
+
+/* ************************************************************************** */
+/*                                 SEARCH                                     */
+/* ************************************************************************** */
+
+/* the outcome of the search is known: keep the squares of the game that
+ * differ from the solution, already in sol */
+static void _warm_found(solver_warm* w, bool solved) {
+  solver* s = w->s;
+  w->searched = true;
+  w->solved = solved;
+  if (!solved) return;
+  for (uint c = 0; c < s->nb_cells; c++)
+    _warm_set_wrong(w, c, w->cur[c] != _code[s->shapes[c]][w->sol[c]]);
+}
+
+/* ************************************************************************** */
+
+/* search a solution from the root, within max_nodes nodes (0 for no limit);
+ * returns false if the budget ran out, the solver being back at the root */
+static bool _warm_search(solver_warm* w, uint64_t max_nodes) {
+  solver* s = w->s;
+  solver_mark root = _solver_mark(s);
+  s->limit = 1;
+  s->nb_nodes = 0;
+  s->status = SOLVER_FINISHED;
+  s->deadline = 0;
+  s->max_nodes = max_nodes;
+  // the bitboard search cannot be stopped on the way
+  bool solved = (max_nodes == 0 && _solver_bitboard_fits(s))
+                    ? _solver_count_bitboard(s, 1) > 0
+                    : _solver_count_subtree(s) > 0;
+  s->max_nodes = 0;
+  if (s->status != SOLVER_FINISHED) {
+    _solver_restore(s, root);
+    return false;
+  }
+  if (solved) memcpy(w->sol, s->dirs, s->nb_cells * sizeof(direction));
+  _warm_found(w, solved);
+  _solver_restore(s, root);
+  _solver_cache_put_solution(s, solved);
+  return true;
+}
+
+/* ************************************************************************** */
+
+/* before any search: a square fixed by the root propagation, or else left
+ * with a single orientation by probing, whose code differs from the game;
+ * probing may also show that there is no solution */
+static bool _warm_root_hint(solver_warm* w, uint* cell, direction* o) {
+  solver* s = w->s;
+  for (uint c = 0; c < s->nb_cells; c++)
+    if (s->shapes[c] != EMPTY && s->placed[c] && s->codes[c] != w->cur[c]) {
+      *cell = c;
+      *o = s->dirs[c];
+      return true;
+    }
+  for (uint c = 0; c < s->nb_cells; c++) {
+    if (s->placed[c] || w->forced[c] == 0) continue;
+    uint left, nb_left = _warm_probe(w, c, &left);
+    w->forced[c] = (nb_left == 1);
+    if (nb_left == 0) {
+      _warm_found(w, false);
+      return false;
+    }
+    if (nb_left == 1 && _code[s->shapes[c]][left] != w->cur[c]) {
+      *cell = c;
+      *o = left;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* ************************************************************************** */
+/*                                ROUTINES                                    */
+/* ************************************************************************** */
+
+solver_warm* _solver_warm_new(cgame g) {
+  assert(g);
+  solver_warm* w = (solver_warm*)malloc(sizeof(solver_warm));
+  assert(w);
+  solver* s = _solver_new(g);
+  uint n = s->nb_cells;
+  w->s = s;
+  w->sol = (direction*)malloc(n * sizeof(direction));
+  w->forced = (signed char*)malloc(n * sizeof(signed char));
+  w->cur = (unsigned char*)malloc(n * sizeof(unsigned char));
+  w->wrong = (uint*)malloc(n * sizeof(uint));
+  w->wrong_pos = (uint*)malloc(n * sizeof(uint));
+  assert(n == 0 ||
+         (w->sol && w->forced && w->cur && w->wrong && w->wrong_pos));
+  w->nb_wrong = 0;
+
+  // the solution may come from the cache, the search is otherwise left to
+  // the first solve or hint that needs it; the solver stays at the root
+  int cached = _solver_cache_get_solution(s);
+  if (cached == 1) memcpy(w->sol, s->dirs, n * sizeof(direction));
+  presolve_report report;
+  w->searched = cached >= 0;
+  w->solved = cached != 0 && _solver_presolve(s, &report) && _solver_init(s);
+  if (!w->solved) w->searched = true;
+
+  // squares fixed by the root propagation need no probing
+  for (uint c = 0; c < n; c++) {
+    uint sh = s->shapes[c], i = c / s->nb_cols, j = c % s->nb_cols;
+    direction o = game_get_piece_orientation(g, i, j);
+    w->forced[c] = (sh == EMPTY) ? 0 : s->placed[c] ? 1 : -1;
+    w->cur[c] = _code[sh][o];
+    w->wrong_pos[c] = NO_CELL;
+  }
+  w->nb_mismatch = 0;
+  for (uint c = 0; c < n; c++)
+    for (direction d = 0; d < NB_DIRS; d++)
+      w->nb_mismatch += _warm_mismatch(w, c, d);
+  if (cached == 1 && w->solved) _warm_found(w, true);
+  return w;
+}
+
+/* ************************************************************************** */
+
+void _solver_warm_update(solver_warm* w, uint c, direction o) {
+  if (!w) return;
+  assert(c < w->s->nb_cells);
+  uint code = _code[w->s->shapes[c]][o];
+  if (code == w->cur[c]) return;
+  w->nb_mismatch -= _warm_mismatch_around(w, c);
+  w->cur[c] = code;
+  w->nb_mismatch += _warm_mismatch_around(w, c);
+  if (w->searched && w->solved)
+    _warm_set_wrong(w, c, code != _code[w->s->shapes[c]][w->sol[c]]);
+}
+
+/* ************************************************************************** */
+
+bool _solver_warm_hint(solver_warm* w, cgame g, uint* cell, direction* o) {
+  assert(w && g && cell && o);
+  if (!w->searched) {
+    if (_warm_root_hint(w, cell, o)) return true;
+    // a won game needs no search
+    if (w->searched || (w->nb_mismatch == 0 && game_won(g))) return false;
+    // the search is bounded, the next hint or solve tries again
+    if (!_warm_search(w, WARM_HINT_NODES)) return false;
+  }
+  if (!w->solved || w->nb_wrong == 0) return false;
+  // first a square whose orientation is forced, known or found by probing
+  for (uint pass = 0; pass < 2; pass++)
+    for (uint k = 0; k < w->nb_wrong; k++) {
+      uint c = w->wrong[k];
+      if (pass == 0 ? w->forced[c] == 1 : _warm_forced(w, c)) {
+        *cell = c;
+        *o = w->sol[c];
+        return true;
+      }
+    }
+  // the game may be won by another solution, which is only possible once all
+  // its half-edges are matched; otherwise a square that differs from the
+  // solution found, which is not forced to be wrong in every solution
+  if (w->nb_mismatch == 0 && game_won(g)) return false;
+  *cell = w->wrong[0];
+  *o = w->sol[*cell];
+  return true;
+}
+
+/* ************************************************************************** */
+
+bool _solver_warm_apply(solver_warm* w, game g) {
+  assert(w && g);
+  if (!w->searched) _warm_search(w, 0);
+  if (!w->solved) return false;
+  // turning a wrong square removes it from the set, the update is already
+  // done by game_set_piece_orientation when w is the state of g
+  while (w->nb_wrong > 0) {
+    uint c = w->wrong[w->nb_wrong - 1];
+    game_set_piece_orientation(g, c / w->s->nb_cols, c % w->s->nb_cols,
+                               w->sol[c]);
+    _solver_warm_update(w, c, w->sol[c]);
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+void _solver_warm_delete(solver_warm* w) {
+  if (!w) return;
+  _solver_delete(w->s);
+  free(w->sol);
+  free(w->forced);
+  free(w->cur);
+  free(w->wrong);
+  free(w->wrong_pos);
+  free(w);
+}
+
+/* ************************************************************************** */
@@ -0,0 +1,394 @@
+/**
+ * @file game_solver_zdd.c
+ * @brief Decision diagram of all the solutions of a grid.
+ * @details The diagram is built in one frontier sweep (see
+ * game_solver_frontier.c): the states of the frontier after k squares are
+ * the nodes of level k, and the state reached with each distinct orientation
+ * of the next square is a child. Over the variables "square c has
+ * orientation o", this is a zero-suppressed diagram in which the nodes of
+ * the orientations of a square are folded into a single node: an
+ * orientation that leads to no solution points to the false terminal.
+ * The diagram is then reduced bottom-up, the nodes without any solution
+ * below them being removed and the nodes of a level with the same children
+ * merged, and the number of paths below and above each node is kept. Each
+ * query then takes a time linear in the size of the diagram:
+ *  - the number of solutions is the number of paths below the root;
+ *  - the solutions in which square c has orientation o are counted by
+ *    above(v) * below(child o of v), over the nodes v of the level of c;
+ *  - a uniform solution follows each child with a probability proportional
+ *    to the number of solutions below it;
+ *  - a square is forced when a single orientation has a child on its level.
+ * The diagram is written as text:
+ *   <nb_rows> <nb_cols> <wrapping>
+ *   one line per row, a shape digit per square
+ *   the square of each level, on one line
+ *   <nb_nodes> <root>
+ *   one line per node but the terminals: its level, then its NB_DIRS children
+ * @copyright University of Bordeaux. All rights reserved, 2024.
+ **/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "game_solver.h"
+#include "game_tools.h"
+
+/* ************************************************************************** */
+/*                             CREATE / DELETE                                */
+/* ************************************************************************** */
+
+static solver_zdd* _zdd_alloc(uint nb_rows, uint nb_cols, bool wrapping) {
+  uint n = nb_rows * nb_cols;
+  solver_zdd* z = (solver_zdd*)malloc(sizeof(solver_zdd));
+  assert(z);
+  z->nb_rows = nb_rows;
+  z->nb_cols = nb_cols;
+  z->wrapping = wrapping;
+  z->shapes = (unsigned char*)malloc(n * sizeof(unsigned char));
+  z->cells = (uint*)malloc(n * sizeof(uint));
+  z->level_start = (uint*)malloc((n + 1) * sizeof(uint));
+  z->capacity = 1024;
+  z->child = (uint*)calloc(z->capacity * NB_DIRS, sizeof(uint));
+  assert((n == 0 || (z->shapes && z->cells)) && z->level_start && z->child);
+  z->nb_nodes = 2;
+  z->root = 0;
+  z->level_start[0] = 2;
+  z->count = NULL;
+  z->below = NULL;
+  z->above = NULL;
+  return z;
+}
+
+/* ************************************************************************** */
+
+solver_zdd* _solver_zdd_new(const solver* s) {
+  assert(s);
+  solver_zdd* z = _zdd_alloc(s->nb_rows, s->nb_cols, s->wrapping);
+  if (s->nb_cells > 0) memcpy(z->shapes, s->shapes, s->nb_cells);
+  return z;
+}
+
+/* ************************************************************************** */
+
+uint _solver_zdd_add_node(solver_zdd* z) {
+  assert(z);
+  if (z->nb_nodes == z->capacity) {
+    z->capacity *= 2;
+    z->child = (uint*)realloc(z->child, z->capacity * NB_DIRS * sizeof(uint));
+    assert(z->child);
+  }
+  for (uint d = 0; d < NB_DIRS; d++) z->child[z->nb_nodes * NB_DIRS + d] = 0;
+  return z->nb_nodes++;
+}
+
+/* ************************************************************************** */
+
+void _solver_zdd_delete(solver_zdd* z) {
+  if (!z) return;
+  free(z->shapes);
+  free(z->cells);
+  free(z->level_start);
+  free(z->child);
+  free(z->count);
+  free(z->below);
+  free(z->above);
+  free(z);
+}
+
+/* ************************************************************************** */
+/*                                REDUCTION                                   */
+/* ************************************************************************** */
+
+static uint _zdd_hash(const uint* children) {
+  uint64_t h = 0;
+  for (uint d = 0; d < NB_DIRS; d++) h = (h ^ children[d]) * 0x100000001B3ULL;
+  h ^= h >> 29;
+  return (uint)h;
+}
+
+/* ************************************************************************** */
+
+/* number of paths below and above each node (the children of a node always
+ * come after it) */
+static void _zdd_count(solver_zdd* z) {
+  uint nb = z->nb_nodes;
+  z->count = (uint64_t*)realloc(z->count, nb * sizeof(uint64_t));
+  z->below = (double*)realloc(z->below, nb * sizeof(double));
+  z->above = (double*)realloc(z->above, nb * sizeof(double));
+  assert(z->count && z->below && z->above);
+  z->count[0] = 0;
+  z->count[1] = 1;
+  z->below[0] = 0.0;
+  z->below[1] = 1.0;
+  for (uint v = nb; v-- > 2;) {
+    z->count[v] = 0;
+    z->below[v] = 0.0;
+    for (uint d = 0; d < NB_DIRS; d++) {
+      uint c = z->child[v * NB_DIRS + d];
+      z->count[v] += z->count[c];
+      z->below[v] += z->below[c];
+    }
+  }
+  for (uint v = 0; v < nb; v++) z->above[v] = 0.0;
+  z->above[z->root] = 1.0;
+  for (uint v = 2; v < nb; v++)
+    for (uint d = 0; d < NB_DIRS; d++)
+      z->above[z->child[v * NB_DIRS + d]] += z->above[v];
+}
+
+/* ************************************************************************** */
+
+void _solver_zdd_reduce(solver_zdd* z) {
+  assert(z);
+  uint n = z->nb_rows * z->nb_cols, nb = z->nb_nodes;
+  uint* rep = (uint*)malloc(nb * sizeof(uint));
+  uint* id = (uint*)calloc(nb, sizeof(uint));
+  assert(rep && id);
+  rep[0] = 0;
+  rep[1] = 1;
+
+  // bottom-up: a node is replaced by the first one of its level with the
+  // same children, or by the false terminal if it has none
+  uint width = 0;
+  for (uint t = 0; t < n; t++)
+    if (z->level_start[t + 1] - z->level_start[t] > width)
+      width = z->level_start[t + 1] - z->level_start[t];
+  uint capacity = 2;
+  while (capacity < 2 * width) capacity *= 2;
+  uint* table = (uint*)malloc(capacity * sizeof(uint));
+  assert(table);
+  for (uint t = n; t-- > 0;) {
+    uint lo = z->level_start[t], hi = z->level_start[t + 1];
+    uint mask = 1;
+    while (mask < 2 * (hi - lo)) mask *= 2;
+    mask--;
+    for (uint k = 0; k <= mask; k++) table[k] = 0;
+    for (uint v = lo; v < hi; v++) {
+      uint* children = &z->child[v * NB_DIRS];
+      bool alive = false;
+      for (uint d = 0; d < NB_DIRS; d++) {
+        children[d] = rep[children[d]];
+        alive = alive || children[d] != 0;
+      }
+      rep[v] = 0;
+      if (!alive) continue;
+      uint h = _zdd_hash(children) & mask;
+      while (table[h] != 0 && memcmp(&z->child[table[h] * NB_DIRS], children,
+                                     NB_DIRS * sizeof(uint)) != 0)
+        h = (h + 1) & mask;
+      if (table[h] == 0) table[h] = v;
+      rep[v] = table[h];
+    }
+  }
+  free(table);
+  if (n > 0) z->root = rep[z->root];
+
+  // top-down: number the nodes left that the root still reaches
+  if (z->root >= 2) id[z->root] = 1;
+  for (uint v = 2; v < nb; v++) {
+    if (rep[v] != v || id[v] == 0) continue;
+    for (uint d = 0; d < NB_DIRS; d++)
+      if (z->child[v * NB_DIRS + d] >= 2) id[z->child[v * NB_DIRS + d]] = 1;
+  }
+  uint next = 2;
+  for (uint t = 0; t < n; t++) {
+    uint lo = z->level_start[t], hi = z->level_start[t + 1];
+    z->level_start[t] = next;
+    for (uint v = lo; v < hi; v++)
+      id[v] = (rep[v] == v && id[v] != 0) ? next++ : 0;
+  }
+  z->level_start[n] = next;
+  id[0] = 0;
+  id[1] = 1;
+
+  // the nodes only move towards the start of the array
+  for (uint v = 2; v < nb; v++) {
+    if (id[v] == 0) continue;
+    for (uint d = 0; d < NB_DIRS; d++)
+      z->child[id[v] * NB_DIRS + d] = id[z->child[v * NB_DIRS + d]];
+  }
+  z->root = (z->root >= 2) ? id[z->root] : z->root;
+  z->nb_nodes = z->capacity = next;
+  z->child = (uint*)realloc(z->child, next * NB_DIRS * sizeof(uint));
+  assert(z->child);
+  free(rep);
+  free(id);
+  _zdd_count(z);
+}
+
+/* ************************************************************************** */
+/*                                 QUERIES                                    */
+/* ************************************************************************** */
+
+static uint _zdd_level(const solver_zdd* z, uint c) {
+  uint t = 0;
+  while (z->cells[t] != c) t++;
+  return t;
+}
+
+/* ************************************************************************** */
+
+double _solver_zdd_fraction(const solver_zdd* z, uint c, direction o) {
+  assert(z && c < z->nb_rows * z->nb_cols && o < NB_DIRS);
+  if (z->root == 0) return 0.0;
+  // the first orientation with the same code is the one kept
+  uint sh = z->shapes[c], d = 0;
+  while (_code[sh][d] != _code[sh][o]) d++;
+  uint t = _zdd_level(z, c);
+  double sum = 0.0;
+  for (uint v = z->level_start[t]; v < z->level_start[t + 1]; v++)
+    sum += z->above[v] * z->below[z->child[v * NB_DIRS + d]];
+  return sum / z->below[z->root];
+}
+
+/* ************************************************************************** */
+
+/* a uniform number in [0, 1), from two calls to rand */
+static double _zdd_uniform(void) {
+  double r = (double)RAND_MAX + 1.0;
+  return ((double)rand() + (double)rand() / r) / r;
+}
+
+/* ************************************************************************** */
+
+bool _solver_zdd_sample(const solver_zdd* z, direction* dirs) {
+  assert(z && dirs);
+  if (z->root == 0) return false;
+  uint n = z->nb_rows * z->nb_cols;
+  uint v = z->root;
+  for (uint t = 0; t < n; t++) {
+    double r = _zdd_uniform() * z->below[v];
+    uint chosen = NB_DIRS;
+    for (uint d = 0; d < NB_DIRS; d++) {
+      uint c = z->child[v * NB_DIRS + d];
+      if (c == 0) continue;
+      chosen = d;
+      r -= z->below[c];
+      if (r < 0.0) break;
+    }
+    assert(chosen < NB_DIRS);
+    dirs[z->cells[t]] = chosen;
+    v = z->child[v * NB_DIRS + chosen];
+  }
+  return true;
+}
+
+/* ************************************************************************** */
+
+uint _solver_zdd_forced(const solver_zdd* z, bool* forced, direction* dirs) {
+  assert(z && forced && dirs);
+  uint n = z->nb_rows * z->nb_cols, nb_forced = 0;
+  for (uint c = 0; c < n; c++) forced[c] = false;
+  if (z->root == 0) return 0;
+  for (uint t = 0; t < n; t++) {
+    uint used = 0;
+    for (uint v = z->level_start[t]; v < z->level_start[t + 1]; v++)
+      for (uint d = 0; d < NB_DIRS; d++)
+        if (z->child[v * NB_DIRS + d] != 0) used |= 1 << d;
+    if (used & (used - 1)) continue;  // several orientations
+    uint c = z->cells[t];
+    forced[c] = true;
+    for (dirs[c] = 0; !(used & (1 << dirs[c])); dirs[c]++) continue;
+    nb_forced++;
+  }
+  return nb_forced;
+}
+
+/* ************************************************************************** */
+/*                                  FILES                                     */
+/* ************************************************************************** */
+
+void _solver_zdd_save(const solver_zdd* z, FILE* f) {
+  assert(z && f);
+  uint n = z->nb_rows * z->nb_cols;
+  fprintf(f, "%u %u %u\n", z->nb_rows, z->nb_cols, z->wrapping ? 1 : 0);
+  for (uint c = 0; c < n; c++)
+    fprintf(f, "%u%c", z->shapes[c],
+            (c % z->nb_cols == z->nb_cols - 1) ? '\n' : ' ');
+  for (uint t = 0; t < n; t++) fprintf(f, "%u%c", z->cells[t], ' ');
+  fprintf(f, "\n%u %u\n", z->nb_nodes, z->root);
+  for (uint t = 0; t < n; t++)
+    for (uint v = z->level_start[t]; v < z->level_start[t + 1]; v++) {
+      fprintf(f, "%u", t);
+      for (uint d = 0; d < NB_DIRS; d++)
+        fprintf(f, " %u", z->child[v * NB_DIRS + d]);
+      fprintf(f, "\n");
+    }
+}
+
+/* ************************************************************************** */
+
+solver_zdd* _solver_zdd_load(FILE* f) {
+  assert(f);
+  uint nb_rows, nb_cols, wrapping;
+  if (fscanf(f, "%u %u %u", &nb_rows, &nb_cols, &wrapping) != 3 ||
+      wrapping > 1)
+    return NULL;
+  uint n = nb_rows * nb_cols;
+  solver_zdd* z = _zdd_alloc(nb_rows, nb_cols, wrapping == 1);
+  bool ok = true;
+  bool* seen = (bool*)calloc(n + 1, sizeof(bool));
+  assert(seen);
+  for (uint c = 0; c < n && ok; c++) {
+    uint sh;
+    ok = fscanf(f, "%u", &sh) == 1 && sh < NB_SHAPES;
+    if (ok) z->shapes[c] = sh;
+  }
+  // the levels must give each square once
+  for (uint t = 0; t < n && ok; t++) {
+    ok = fscanf(f, "%u", &z->cells[t]) == 1 && z->cells[t] < n &&
+         !seen[z->cells[t]];
+    if (ok) seen[z->cells[t]] = true;
+  }
+  free(seen);
+  uint nb_nodes, root;
+  ok = ok && fscanf(f, "%u %u", &nb_nodes, &root) == 2 && nb_nodes >= 2 &&
+       root < nb_nodes;
+
+  // the nodes come level by level
+  uint t = 0;
+  for (uint v = 2; v < nb_nodes && ok; v++) {
+    uint level;
+    ok = fscanf(f, "%u", &level) == 1 && level >= t && level < n;
+    for (; ok && t < level; t++) z->level_start[t + 1] = v;
+    ok = ok && _solver_zdd_add_node(z) == v;
+    for (uint d = 0; d < NB_DIRS && ok; d++)
+      ok = fscanf(f, "%u", &z->child[v * NB_DIRS + d]) == 1;
+  }
+  for (; t < n; t++) z->level_start[t + 1] = nb_nodes;
+
+  // the root is on the first level, the children of a node on the next one
+  // (terminals after the last level), and only distinct orientations have
+  // children
+  if (n == 0)
+    ok = ok && nb_nodes == 2 && root < 2;
+  else
+    ok = ok && (root == 0 || (root >= 2 && root < z->level_start[1]));
+  for (t = 0; t < n && ok; t++) {
+    uint sh = z->shapes[z->cells[t]];
+    uint lo = (t + 1 < n) ? z->level_start[t + 1] : 1;
+    uint hi = (t + 1 < n) ? z->level_start[t + 2] : 2;
+    for (uint v = z->level_start[t]; v < z->level_start[t + 1] && ok; v++)
+      for (uint d = 0; d < NB_DIRS && ok; d++) {
+        uint c = z->child[v * NB_DIRS + d];
+        bool distinct = true;
+        for (uint k = 0; k < d; k++)
+          if (_code[sh][k] == _code[sh][d]) distinct = false;
+        ok = c == 0 || (distinct && c >= lo && c < hi);
+      }
+  }
+  if (!ok) {
+    _solver_zdd_delete(z);
+    return NULL;
+  }
+  z->root = root;
+  _solver_zdd_reduce(z);
+  return z;
+}
+
+/* ************************************************************************** */
@@ -27,12 +27,14 @@ typedef struct square_s {
  * @details This is an opaque data type.
  */
 struct game_s {
-  uint nb_rows;      /**< number of rows in the game */
-  uint nb_cols;      /**< number of columns in the game */
-  square* squares;   /**< the grid of squares using row-major storage */
-  bool wrapping;     /**< the wrapping option */
-  queue* undo_stack; /**< stack to undo moves */
-  queue* redo_stack; /**< stack to redo moves */
+  uint nb_rows;               /**< number of rows in the game */
+  uint nb_cols;               /**< number of columns in the game */
+  square* squares;            /**< the grid of squares, in row-major order */
+  bool wrapping;              /**< the wrapping option */
+  queue* undo_stack;          /**< stack to undo moves */
+  queue* redo_stack;          /**< stack to redo moves */
+  struct solver_warm_s* warm; /**< solver state kept between two solves, or
+                                   NULL (see game_solver_warm.c) */
 };
 
 /* ************************************************************************** */
@@ -31,9 +31,21 @@ int main(int argc, char *argv[]) {
       printf("press 'c <i> <j>' to rotate piece clockwise in square (i,j)\n");
       printf(
           "press 'a <i> <j>' to rotate piece anti-clockwise in square (i,j)\n");
+      printf("press 'i' to get a hint (the piece is rotated)\n");
       printf("press 'r' to shuffle game\n");
       printf("press 'q' to quit\n");
     }
+    if (c == 'i') {
+      uint i, j;
+      direction o;
+      if (game_hint(g, &i, &j, &o)) {
+        int dir = (o - game_get_piece_orientation(g, i, j) + 4) % 4;
+        game_play_move(g, i, j, dir);
+        printf("action: hint into square (%u,%u)\n", i, j);
+      } else {
+        printf("No hint available.\n");
+      }
+    }
     if (c == 'r') {
       printf("action: shuffle\n");
       game_shuffle_orientation(g);
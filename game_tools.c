@@ -2,6 +2,7 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +12,7 @@
 #include "game_aux.h"
 #include "game_ext.h"
 #include "game_private.h"
+#include "game_solver.h"
 #include "game_struct.h"
 #include "queue.h"
 
@@ -250,189 +252,484 @@ game game_random(uint nb_rows, uint nb_cols, bool wrapping, uint nb_empty,
     free(extras);
   }
 
+  // validation : le jeu construit doit passer le pré-traitement
+  if (!game_presolve(g, NULL)) {
+    game_delete(g);
+    return NULL;
+  }
   return g;
 }
 
-// Retourne les orientations possibles pour une pièce
-static void get_possible_directions(shape s, direction* dirs, uint* nb_dirs) {
-  *nb_dirs = 0;
-  switch (s) {
-    case SEGMENT:
-      dirs[(*nb_dirs)++] = NORTH;  // symétrie : NORTH/SOUTH
-      dirs[(*nb_dirs)++] = EAST;   // symétrie : EAST/WEST
-      break;
-    case CROSS:
-      dirs[(*nb_dirs)++] = NORTH;  // une seule orientation suffit
-      break;
-    default:  // CORNER, TEE, ENDPOINT, EMPTY
-      for (direction d = NORTH; d <= WEST; d++) {
-        dirs[(*nb_dirs)++] = d;
-      }
-      break;
-  }
+// modification de la fonction game_solve :
+
+bool game_solve(
+    game g)  // on prends comme parametre le jeu qu'on a envie de résoudre
+{
+  bool solved;
+  game_solve_opts(g, NULL, &solved);
+  // si une solution est trouvé notre variable solved ==true; sinon false dans
+  // le cas contraire
+  if (solved) {
+    printf(
+        "Solution a été trouvé avec succès ! le jeu a été résolu");  // on
+                                                                     // affiche
+                                                                     // un
+                                                                     // message
+                                                                     // dans le
+                                                                     // terminal
+  } else
+    printf("Aucune solution n'a été trouvé pour le jeu !");
+
+  // ici on retourne la valeur de solved
+  return solved;
 }
 
-// Vérification complète locale (vérifie les voisins gauches et supérieurs,
-// ainsi que les contraintes wrap-around si applicable)
-static bool check_local_edges(cgame g, uint i, uint j) {
-  if (j > 0 && game_check_edge(g, i, j - 1, EAST) == MISMATCH) return false;
-  if (i > 0 && game_check_edge(g, i - 1, j, SOUTH) == MISMATCH) return false;
-  if (game_is_wrapping(g)) {
-    if (j == 0 && game_check_edge(g, i, game_nb_cols(g) - 1, EAST) == MISMATCH)
-      return false;
-    if (i == 0 && game_check_edge(g, game_nb_rows(g) - 1, j, SOUTH) == MISMATCH)
-      return false;
-  }
-  return true;
+// recopie les limites des options dans le solveur
+static void _set_options(solver* s, const game_solve_options* opts) {
+  if (!opts) return;
+  s->time_limit = opts->time_limit;
+  s->max_nodes = opts->max_nodes;
+  s->cancel = opts->cancel;
+  s->progress = opts->progress;
+  s->progress_every = opts->progress_every;
+  s->progress_ctx = opts->ctx;
 }
 
-// Vérification partielle : ne vérifie que les voisins qui sont assurément
-// assignés
-static bool check_partial_edges(cgame g, uint i, uint j) {
-  // On vérifie uniquement le voisin à gauche et au-dessus,
-  // car ils sont toujours assignés lors du parcours en ligne.
-  if (j > 0 && game_check_edge(g, i, j - 1, EAST) == MISMATCH) return false;
-  if (i > 0 && game_check_edge(g, i - 1, j, SOUTH) == MISMATCH) return false;
-  return true;
+// les options limitent-elles ou suivent-elles la recherche ? le balayage de
+// frontière ne les consulte pas
+static bool _has_limits(const game_solve_options* opts) {
+  return opts && (opts->time_limit > 0 || opts->max_nodes > 0 ||
+                  opts->cancel || opts->progress);
+}
+
+// les deux énumérations suivent le même ordre
+static game_run_status _run_status(const solver* s) {
+  return (game_run_status)s->status;
 }
 
-// ------------------
-// Résolution récursive pour trouver UNE solution
-// ------------------
-bool solve_recursive(game g, int index, uint* count, bool stop_early) {
-  // Si le jeu est déjà résolu, incrémenter le compteur et retourner true
-  if (game_won(g)) {
-    if (count) (*count)++;
-    return true;
+game_run_status game_solve_opts(game g, const game_solve_options* opts,
+                                bool* solved) {
+  *solved = false;
+  if (!g) return GAME_RUN_FINISHED;
+  // sans limite, la solution reste attachée au jeu et seules les pièces
+  // tournées depuis sont remises en place ; l'état gardé avec le jeu (par un
+  // indice par exemple) peut ne pas avoir été cherché, une recherche avec des
+  // limites passe donc toujours par un nouveau solveur
+  if (!opts) {
+    if (!g->warm) g->warm = _solver_warm_new(g);
+    *solved = _solver_warm_apply(g->warm, g);
+    return GAME_RUN_FINISHED;
   }
+  // la recherche se fait sur une copie privée des codes des pièces, les
+  // orientations trouvées ne sont recopiées dans le jeu qu'une seule fois
+  solver* s = _solver_new(g);
+  _set_options(s, opts);
+  // une grille déjà résolue est relue dans le cache, et les jeux rejetés par
+  // le pré-traitement ne sont pas cherchés
+  int cached = _solver_cache_get_solution(s);
+  presolve_report report;
+  if (cached >= 0)
+    *solved = cached;
+  else
+    *solved = _solver_presolve(s, &report) && _solver_solve(s);
+  game_run_status status = _run_status(s);
+  if (cached < 0 && status == GAME_RUN_FINISHED)
+    _solver_cache_put_solution(s, *solved);
+  if (*solved) _solver_apply(s, g);
+  _solver_delete(s);
+  return status;
+}
 
-  // Si nous avons parcouru toutes les cases, il n'y a pas de solution
-  if (index >= game_nb_rows(g) * game_nb_cols(g)) {
-    return false;
+game_run_status game_nb_solutions_opts(cgame g, const game_solve_options* opts,
+                                       uint64_t* nb_solutions) {
+  *nb_solutions = 0;
+  if (!g) return GAME_RUN_FINISHED;
+  solver* s = _solver_new(g);
+  _set_options(s, opts);
+  presolve_report report;
+  if (!_solver_cache_get_count(s, nb_solutions)) {
+    // balayage de frontière sur les grilles étroites sans limite, recherche
+    // sinon
+    if (!_solver_presolve(s, &report))
+      *nb_solutions = 0;
+    else if (!_has_limits(opts) && _solver_frontier_fits(s))
+      *nb_solutions = _solver_count_frontier(s);
+    else
+      *nb_solutions = _solver_count(s, UINT64_MAX);
+    if (s->status == SOLVER_FINISHED)
+      _solver_cache_put_count(s, *nb_solutions);
   }
+  game_run_status status = _run_status(s);
+  _solver_delete(s);
+  return status;
+}
 
-  // Calculer les coordonnées (i, j) correspondant à l'index
-  uint i = index / game_nb_cols(g);
-  uint j = index % game_nb_cols(g);
+uint game_nb_solutions(cgame g) {
+  uint64_t nb_solutions;
+  game_nb_solutions_opts(g, NULL, &nb_solutions);
+  return nb_solutions;
+}
 
-  // Récupérer la forme et l'orientation actuelles de la pièce
-  shape s = game_get_piece_shape(g, i, j);
-  direction original_orientation = game_get_piece_orientation(g, i, j);
+uint64_t game_nb_solutions_parallel(cgame g, uint nb_threads, uint depth) {
+  if (!g) return 0;
+  if (depth == 0) depth = SOLVER_SPLIT_DEPTH;
+  solver* s = _solver_new(g);
+  uint64_t nb_solutions = _solver_count_parallel(s, nb_threads, depth);
+  _solver_delete(s);
+  return nb_solutions;
+}
 
-  // Ignorer les cases vides
-  if (s == EMPTY) {
-    return solve_recursive(g, index + 1, count, stop_early);
+uint64_t game_nb_solutions_limit(cgame g, uint64_t limit) {
+  if (!g) return 0;
+  if (limit == 0) limit = UINT64_MAX;
+  solver* s = _solver_new(g);
+  uint64_t nb_solutions;
+  presolve_report report;
+  if (_solver_cache_get_count(s, &nb_solutions)) {
+    if (nb_solutions > limit) nb_solutions = limit;
+  } else if (!_solver_presolve(s, &report)) {
+    nb_solutions = 0;
+    _solver_cache_put_count(s, 0);
+  } else if (_solver_frontier_fits(s)) {
+    // le balayage compte tout d'un coup, il suffit de borner le résultat
+    nb_solutions = _solver_count_frontier(s);
+    _solver_cache_put_count(s, nb_solutions);
+    if (nb_solutions > limit) nb_solutions = limit;
+  } else {
+    nb_solutions = _solver_count(s, limit);
+    // en dessous de la limite, la recherche a tout compté
+    if (nb_solutions < limit) _solver_cache_put_count(s, nb_solutions);
   }
+  _solver_delete(s);
+  return nb_solutions;
+}
 
-  // Déterminer le nombre d'orientations possibles pour la pièce
-  int nb_orientations = (s == SEGMENT || s == CROSS) ? 2 : 4;
+bool game_has_unique_solution(cgame g) {
+  return game_nb_solutions_limit(g, 2) == 1;
+}
 
-  for (int orientation = 0; orientation < nb_orientations; orientation++) {
-    // Appliquer l'orientation courante
-    game_set_piece_orientation(g, i, j, orientation);
+game_estimate game_estimate_solutions(cgame g, double rel_error,
+                                      double confidence, uint64_t budget) {
+  game_estimate r = {0.0, 0.0, 0.0, 0, true, true};
+  if (!g) return r;
+  solver* s = _solver_new(g);
+  uint64_t nb_solutions;
+  if (_solver_cache_get_count(s, &nb_solutions)) {
+    r.estimate = r.low = r.high = (double)nb_solutions;
+  } else {
+    solver_estimate e = _solver_estimate(s, rel_error, confidence, budget);
+    r.estimate = e.estimate;
+    r.low = e.low;
+    r.high = e.high;
+    r.nb_probes = e.nb_probes;
+    r.exact = e.exact;
+    r.converged = e.converged;
+  }
+  _solver_delete(s);
+  return r;
+}
 
-    // Vérifier si cette configuration résout le jeu
-    if (game_won(g)) {
-      if (count) (*count)++;
-      return true;
-    }
+bool game_solve_portfolio(game g, uint nb_threads) {
+  if (!g) return false;
+  solver* s = _solver_new(g);
+  int cached = _solver_cache_get_solution(s);
+  presolve_report report;
+  bool solved = (cached >= 0) ? cached
+                              : _solver_presolve(s, &report) &&
+                                    _solver_solve_portfolio(s, nb_threads);
+  if (cached < 0 && s->status == SOLVER_FINISHED)
+    _solver_cache_put_solution(s, solved);
+  if (solved) _solver_apply(s, g);
+  _solver_delete(s);
+  return solved;
+}
 
-    // Vérifier les bords adjacents pour éviter les incohérences
-    bool valid_edges = true;
+bool game_solve_tiled(game g, uint tile_size, uint nb_threads) {
+  if (!g) return false;
+  solver* s = _solver_new(g);
+  presolve_report report;
+  bool solved = _solver_presolve(s, &report) &&
+                _solver_solve_tiled(s, tile_size, nb_threads);
+  if (solved) _solver_apply(s, g);
+  _solver_delete(s);
+  return solved;
+}
 
-    if (i > 0 && game_check_edge(g, i, j, NORTH) == MISMATCH) {
-      valid_edges = false;
-    }
-    if (j > 0 && game_check_edge(g, i, j, WEST) == MISMATCH) {
-      valid_edges = false;
-    }
+uint game_solve_batch(game* games, uint nb_games, bool* solved) {
+  if (!games) return 0;
+  return _solver_solve_batch(games, nb_games, solved);
+}
 
-    if (valid_edges) {
-      // Continuer la résolution récursive
-      if (solve_recursive(g, index + 1, count, stop_early)) {
-        if (stop_early) {
-          return true;  // Arrêter dès qu'une solution est trouvée
-        }
-      }
-    }
+bool game_solve_local(game g, double time_limit, uint* nb_unmatched) {
+  if (!g) return false;
+  solver* s = _solver_new(g);
+  uint nb = _solver_solve_local(s, time_limit);
+  // le meilleur état est recopié même s'il n'est pas une solution
+  _solver_apply(s, g);
+  bool solved = s->nb_solutions > 0;
+  if (nb_unmatched) *nb_unmatched = nb;
+  _solver_delete(s);
+  return solved;
+}
+
+uint64_t game_foreach_solution(cgame g,
+                               bool (*cb)(const direction* sol, void* ctx),
+                               void* ctx) {
+  if (!g || !cb) return 0;
+  solver* s = _solver_new(g);
+  // les solutions sont lues directement dans les orientations du solveur
+  s->on_solution = cb;
+  s->on_solution_ctx = ctx;
+  uint64_t nb_solutions = _solver_count(s, UINT64_MAX);
+  _solver_delete(s);
+  return nb_solutions;
+}
+
+// diagramme de décision de toutes les solutions d'un jeu
+struct game_zdd_s {
+  solver_zdd* z;
+};
+
+game_zdd game_zdd_new(cgame g) {
+  if (!g) return NULL;
+  solver* s = _solver_new(g);
+  if (!_solver_frontier_fits(s)) {
+    _solver_delete(s);
+    return NULL;
   }
+  game_zdd z = (game_zdd)malloc(sizeof(struct game_zdd_s));
+  assert(z);
+  z->z = _solver_compile_frontier(s);
+  _solver_delete(s);
+  return z;
+}
+
+void game_zdd_delete(game_zdd z) {
+  if (!z) return;
+  _solver_zdd_delete(z->z);
+  free(z);
+}
+
+uint game_zdd_size(game_zdd z) {
+  assert(z);
+  return z->z->nb_nodes;
+}
+
+uint64_t game_zdd_nb_solutions(game_zdd z) {
+  assert(z);
+  return z->z->count[z->z->root];
+}
+
+double game_zdd_fraction(game_zdd z, uint i, uint j, direction o) {
+  assert(z && i < z->z->nb_rows && j < z->z->nb_cols && o < NB_DIRS);
+  return _solver_zdd_fraction(z->z, i * z->z->nb_cols + j, o);
+}
 
-  // Restaurer l'orientation initiale avant de retourner false
-  game_set_piece_orientation(g, i, j, original_orientation);
-  return false;
-}
-// ------------------
-// Comptage des solutions avec élagage optimisé
-// ------------------
-static void _count_solutions_recursive(game g, uint pos, uint* nb_solutions) {
-  uint nb_rows = game_nb_rows(g);
-  uint nb_cols = game_nb_cols(g);
-  uint total = nb_rows * nb_cols;
-
-  if (pos >= total) {
-    if (game_won(g)) (*nb_solutions)++;
-    return;
+bool game_zdd_sample(game_zdd z, game g) {
+  if (!z || !g) return false;
+  const solver_zdd* d = z->z;
+  if (game_nb_rows(g) != d->nb_rows || game_nb_cols(g) != d->nb_cols ||
+      game_is_wrapping(g) != d->wrapping)
+    return false;
+  for (uint c = 0; c < d->nb_rows * d->nb_cols; c++)
+    if (game_get_piece_shape(g, c / d->nb_cols, c % d->nb_cols) !=
+        d->shapes[c])
+      return false;
+  uint n = d->nb_rows * d->nb_cols;
+  direction* dirs = (direction*)malloc(n * sizeof(direction));
+  assert(n == 0 || dirs);
+  bool ok = _solver_zdd_sample(d, dirs);
+  // une pièce déjà dans une orientation équivalente n'est pas tournée
+  for (uint c = 0; c < n && ok; c++) {
+    uint i = c / d->nb_cols, j = c % d->nb_cols;
+    direction o = game_get_piece_orientation(g, i, j);
+    if (_code[d->shapes[c]][o] != _code[d->shapes[c]][dirs[c]])
+      game_set_piece_orientation(g, i, j, dirs[c]);
   }
+  free(dirs);
+  return ok;
+}
 
-  uint i = pos / nb_cols;
-  uint j = pos % nb_cols;
+uint game_zdd_forced(game_zdd z, bool* forced, direction* dirs) {
+  assert(z && forced && dirs);
+  return _solver_zdd_forced(z->z, forced, dirs);
+}
 
-  if (!game_is_wrapping(g)) {
-    // Pour un jeu non wrapping, la ligne précédente est entièrement assignée
-    if (j == 0 && i > 0) {
-      for (uint c = 0; c < nb_cols; c++) {
-        if (!check_local_edges(g, i - 1, c)) return;
-      }
+bool game_zdd_save(game_zdd z, char* filename) {
+  assert(z && filename);
+  FILE* f = fopen(filename, "w");
+  if (!f) return false;
+  _solver_zdd_save(z->z, f);
+  return fclose(f) == 0;
+}
+
+game_zdd game_zdd_load(char* filename) {
+  assert(filename);
+  FILE* f = fopen(filename, "r");
+  if (!f) return NULL;
+  solver_zdd* d = _solver_zdd_load(f);
+  fclose(f);
+  if (!d) return NULL;
+  game_zdd z = (game_zdd)malloc(sizeof(struct game_zdd_s));
+  assert(z);
+  z->z = d;
+  return z;
+}
+
+bool game_hint(game g, uint* i, uint* j, direction* o) {
+  if (!g || !i || !j || !o) return false;
+  if (!g->warm) g->warm = _solver_warm_new(g);
+  uint c;
+  direction target;
+  if (!_solver_warm_hint(g->warm, g, &c, &target)) return false;
+  *i = c / game_nb_cols(g);
+  *j = c % game_nb_cols(g);
+  // parmi les orientations équivalentes, la première dans le sens horaire
+  shape sh = game_get_piece_shape(g, *i, *j);
+  direction cur = game_get_piece_orientation(g, *i, *j);
+  *o = target;
+  for (uint k = 1; k < NB_DIRS; k++)
+    if (_code[sh][(cur + k) % NB_DIRS] == _code[sh][target]) {
+      *o = (cur + k) % NB_DIRS;
+      break;
     }
-    // Vérification complète pour la case courante
-    if (!check_local_edges(g, i, j)) return;
-  } else {
-    // Pour les jeux wrapping, on effectue uniquement une vérification partielle
-    if (!check_partial_edges(g, i, j)) return;
+  return true;
+}
+
+// solveur pas à pas : la recherche en cours et la meilleure affectation
+// partielle vue à la fin d'une tranche
+struct game_solver_s {
+  solver* s;
+  game_solver_state state;
+  uint64_t nb_nodes; /* noeuds des tranches précédentes */
+  uint nb_best;      /* pièces fixées dans best */
+  bool* fixed;       /* la case est-elle fixée dans best ? */
+  direction* best;   /* orientations de la meilleure affectation */
+};
+
+// garde l'affectation courante du solveur si elle fixe plus de pièces
+static void _solver_keep_best(game_solver gs) {
+  solver* s = gs->s;
+  bool all = (gs->state == GAME_SOLVER_SOLVED);
+  if (!all && s->nb_placed <= gs->nb_best) return;
+  gs->nb_best = all ? s->nb_pieces : s->nb_placed;
+  for (uint c = 0; c < s->nb_cells; c++) {
+    gs->fixed[c] = s->shapes[c] != EMPTY && (all || s->placed[c]);
+    gs->best[c] = s->dirs[c];
   }
+}
 
-  shape s = game_get_piece_shape(g, i, j);
-  direction original_dir = game_get_piece_orientation(g, i, j);
-  direction dirs[4];
-  uint nb_dirs;
-  get_possible_directions(s, dirs, &nb_dirs);
+game_solver game_solver_new(cgame g) {
+  assert(g);
+  game_solver gs = (game_solver)malloc(sizeof(struct game_solver_s));
+  assert(gs);
+  gs->s = _solver_new(g);
+  uint n = gs->s->nb_cells;
+  gs->fixed = (bool*)calloc(n, sizeof(bool));
+  gs->best = (direction*)malloc(n * sizeof(direction));
+  assert(n == 0 || (gs->fixed && gs->best));
+  gs->nb_nodes = 0;
+  gs->nb_best = 0;
+  // une solution déjà attachée au jeu est reprise telle quelle, sinon la
+  // racine (pré-traitement et propagation) est calculée tout de suite
+  if (g->warm && g->warm->searched) {
+    gs->state = g->warm->solved ? GAME_SOLVER_SOLVED : GAME_SOLVER_NO_SOLUTION;
+    memcpy(gs->s->dirs, g->warm->sol, n * sizeof(direction));
+  } else if (!_solver_start(gs->s))
+    gs->state = GAME_SOLVER_NO_SOLUTION;
+  else if (gs->s->nb_solutions > 0)
+    gs->state = GAME_SOLVER_SOLVED;
+  else
+    gs->state = GAME_SOLVER_RUNNING;
+  if (gs->state != GAME_SOLVER_NO_SOLUTION) _solver_keep_best(gs);
+  return gs;
+}
+
+game_solver_state game_solver_step(game_solver gs, uint max_nodes) {
+  assert(gs);
+  if (gs->state != GAME_SOLVER_RUNNING) return gs->state;
+  solver* s = gs->s;
+  s->nb_nodes = 0;
+  s->max_nodes = max_nodes;
+  bool stopped = _solver_resume(s);
+  gs->nb_nodes += s->nb_nodes;
+  if (!stopped)
+    gs->state = GAME_SOLVER_NO_SOLUTION;
+  else if (s->status == SOLVER_FINISHED)
+    gs->state = GAME_SOLVER_SOLVED;
+  if (gs->state != GAME_SOLVER_NO_SOLUTION) _solver_keep_best(gs);
+  return gs->state;
+}
 
-  for (uint k = 0; k < nb_dirs; k++) {
-    game_set_piece_orientation(g, i, j, dirs[k]);
-    _count_solutions_recursive(g, pos + 1, nb_solutions);
+uint game_solver_best(game_solver gs, game g) {
+  assert(gs && g);
+  const solver* s = gs->s;
+  assert(game_nb_rows(g) == s->nb_rows && game_nb_cols(g) == s->nb_cols);
+  for (uint c = 0; c < s->nb_cells; c++) {
+    if (!gs->fixed[c]) continue;
+    uint i = c / s->nb_cols, j = c % s->nb_cols;
+    direction o = game_get_piece_orientation(g, i, j);
+    if (_code[s->shapes[c]][o] != _code[s->shapes[c]][gs->best[c]])
+      game_set_piece_orientation(g, i, j, gs->best[c]);
   }
-  game_set_piece_orientation(g, i, j, original_dir);
+  return gs->nb_best;
 }
 
-// modification de la fonction game_solve :
+uint64_t game_solver_nb_nodes(game_solver gs) {
+  assert(gs);
+  return gs->nb_nodes;
+}
 
-bool game_solve(
-    game g)  // on prends comme parametre le jeu qu'on a envie de résoudre
-{
-  bool solved = solve_recursive(
-      g, 0, NULL, true);  // ici on execute la fonction solve_recursive
-  // si une solution est trouvé notre variable solved ==true; sinon false dans
-  // le cas contraire
-  if (solved) {
-    printf(
-        "Solution a été trouvé avec succès ! le jeu a été résolu");  // on
-                                                                     // affiche
-                                                                     // un
-                                                                     // message
-                                                                     // dans le
-                                                                     // terminal
-  } else
-    printf("Aucune solution n'a été trouvé pour le jeu !");
+void game_solver_delete(game_solver gs) {
+  if (!gs) return;
+  _solver_delete(gs->s);
+  free(gs->fixed);
+  free(gs->best);
+  free(gs);
+}
 
-  // ici on retourne la valeur de solved
+void game_cache_set_dir(const char* dir) { _solver_cache_set_dir(dir); }
+
+void game_cache_clear(void) {
+  _solver_cache_clear();
+  _solver_tiles_clear();
+}
+
+bool game_presolve(cgame g, FILE* f) {
+  if (!g) return false;
+  static const char* reasons[] = {
+      "ok", "odd number of half-edges", "fewer edges than pieces - 1",
+      "pieces that cannot reach the others", "square without orientation"};
+  solver* s = _solver_new(g);
+  presolve_report r;
+  bool ok = _solver_presolve(s, &r);
+  _solver_delete(s);
+  if (f) {
+    fprintf(f, "pieces: %u\n", r.nb_pieces);
+    fprintf(f, "half-edges: %u\n", r.nb_half_edges);
+    if (ok) {
+      fprintf(f, "fixed pieces: %u\n", r.nb_fixed);
+      fprintf(f, "orientations ruled out: %u\n", r.nb_removed);
+    }
+    fprintf(f, "status: %s\n", reasons[r.status]);
+  }
+  return ok;
+}
+
+bool game_solve_sat(game g) {
+  if (!g) return false;
+  solver* s = _solver_new(g);
+  s->mode = SOLVER_SAT;
+  presolve_report report;
+  bool solved = _solver_presolve(s, &report) && _solver_solve(s);
+  if (solved) _solver_apply(s, g);
+  _solver_delete(s);
   return solved;
 }
 
-uint game_nb_solutions(cgame g) {
-  if (!g) return 0;
-  game g_copy = game_copy(g);
-  uint nb_solutions = 0;
-  _count_solutions_recursive(g_copy, 0, &nb_solutions);
-  game_delete(g_copy);
-  return nb_solutions;
+void game_export_dimacs(cgame g, FILE* f) {
+  if (!g || !f) return;
+  solver* s = _solver_new(g);
+  _solver_export_dimacs(s, f);
+  _solver_delete(s);
 }
@@ -1,6 +1,7 @@
 
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -135,13 +136,416 @@ void game_save(cgame g, char* filename);
 game game_random(uint nb_rows, uint nb_cols, bool wrapping, uint nb_empty,
                  uint nb_extra);
 
+/**
+ * @brief Limites et suivi d'une recherche (voir game_solve_opts).
+ * @details Un champ à 0 (ou NULL) ne limite rien.
+ */
+typedef struct {
+  double time_limit;     /**< durée maximale, en secondes */
+  uint64_t max_nodes;    /**< nombre maximal de noeuds de la recherche */
+  volatile bool* cancel; /**< la recherche s'arrête dès qu'il passe à true,
+                              ce qu'un autre thread peut faire */
+  /** appelée tous les progress_every noeuds avec le nombre de noeuds et la
+   * profondeur courante */
+  void (*progress)(uint64_t nb_nodes, uint depth, void* ctx);
+  uint64_t progress_every; /**< période de progress, en noeuds */
+  void* ctx;               /**< pointeur transmis tel quel à progress */
+} game_solve_options;
+
+/** Issue d'une recherche lancée avec des options. */
+typedef enum {
+  GAME_RUN_FINISHED,   /**< la recherche est allée jusqu'au bout */
+  GAME_RUN_TIMEOUT,    /**< la durée maximale est atteinte */
+  GAME_RUN_NODE_LIMIT, /**< le nombre maximal de noeuds est atteint */
+  GAME_RUN_CANCELLED,  /**< la recherche a été annulée */
+} game_run_status;
+
 /**
  * @brief Calcule le nombre de solutions possibles pour un jeu.
+ * @details Seules les orientations distinctes sont comptées : deux solutions
+ * sont différentes si au moins une pièce n'y a pas les mêmes demi-arêtes. Les
+ * orientations qui donnent les mêmes connexions ne comptent qu'une fois (une
+ * seule pour une case vide ou une CROSS, deux pour un SEGMENT) : les cases
+ * vides ne multiplient donc pas le nombre de solutions par 4.
  * @param g Le jeu à analyser.
  * @return Le nombre de solutions.
  */
 uint game_nb_solutions(cgame g);
 
+/**
+ * @brief Calcule le nombre de solutions, dans les limites données.
+ * @details Sans limite ni suivi, les grilles étroites sont comptées par
+ * balayage de frontière ; sinon la recherche est utilisée, seule à consulter
+ * les limites et à appeler progress.
+ * @param g Le jeu à analyser.
+ * @param opts Les limites de la recherche (NULL : aucune).
+ * @param nb_solutions Reçoit le nombre de solutions, ou celui des solutions
+ * trouvées avant l'arrêt si la recherche n'est pas allée au bout.
+ * @return GAME_RUN_FINISHED si le compte est complet, sinon la raison de
+ * l'arrêt.
+ */
+game_run_status game_nb_solutions_opts(cgame g, const game_solve_options* opts,
+                                       uint64_t* nb_solutions);
+
+/**
+ * @brief Calcule le nombre de solutions en répartissant la recherche sur
+ * plusieurs threads.
+ * @details L'arbre de recherche est découpé en tâches, réparties entre les
+ * threads par vol de travail (work stealing). Le résultat est le même que
+ * celui de game_nb_solutions (orientations distinctes seulement). Un
+ * découpage plus profond donne des tâches plus nombreuses et plus petites,
+ * mieux réparties entre les threads mais plus coûteuses à préparer.
+ * @param g Le jeu à analyser.
+ * @param nb_threads Nombre de threads (0 pour utiliser tous les coeurs).
+ * @param depth Nombre de décisions après lequel l'arbre est découpé (0 pour
+ * la profondeur par défaut, 10).
+ * @return Le nombre de solutions.
+ */
+uint64_t game_nb_solutions_parallel(cgame g, uint nb_threads, uint depth);
+
+/**
+ * @brief Choisit le répertoire où les solutions calculées sont conservées.
+ * @details Les solutions d'un jeu ne dépendent que de ses dimensions, de
+ * l'option wrapping et des formes de ses pièces. game_solve et
+ * game_nb_solutions gardent en mémoire les résultats des derniers jeux
+ * rencontrés ; avec un répertoire, ils sont aussi écrits sur disque (un
+ * fichier par grille) et retrouvés d'une exécution à l'autre.
+ * @param dir Le répertoire (qui doit exister), ou NULL pour n'utiliser que
+ * la mémoire.
+ */
+void game_cache_set_dir(const char* dir);
+
+/**
+ * @brief Oublie les solutions conservées en mémoire, ainsi que les tuiles
+ * gardées par game_solve_tiled (les fichiers du répertoire choisi par
+ * game_cache_set_dir sont gardés).
+ */
+void game_cache_clear(void);
+
+/**
+ * @brief Compte les solutions d'un jeu, en s'arrêtant dès que limit
+ * solutions ont été trouvées.
+ * @details Utile quand seule une borne compte (par exemple pour savoir si
+ * la solution est unique) : la recherche n'explore pas le reste de l'arbre.
+ * Les solutions sont comptées comme par game_nb_solutions, orientations
+ * distinctes seulement.
+ * @param g Le jeu à analyser.
+ * @param limit Nombre de solutions au-delà duquel on arrête (0 pour les
+ * compter toutes).
+ * @return Le nombre de solutions, au plus limit.
+ */
+uint64_t game_nb_solutions_limit(cgame g, uint64_t limit);
+
+/**
+ * @brief Teste si un jeu a exactement une solution.
+ * @details La recherche s'arrête à la deuxième solution trouvée.
+ * @param g Le jeu à analyser.
+ * @return true si le jeu a une unique solution, false sinon.
+ */
+bool game_has_unique_solution(cgame g);
+
+/** Estimation du nombre de solutions (voir game_estimate_solutions). */
+typedef struct {
+  double estimate;    /**< nombre de solutions estimé */
+  double low;         /**< borne basse de l'intervalle de confiance */
+  double high;        /**< borne haute de l'intervalle de confiance */
+  uint64_t nb_probes; /**< nombre de sondes tirées */
+  bool exact;         /**< l'estimation est-elle le nombre exact ? */
+  bool converged;     /**< l'intervalle a-t-il atteint l'erreur relative
+                           demandée avant la fin du budget ? */
+} game_estimate;
+
+/**
+ * @brief Estime le nombre de solutions d'un jeu trop grand pour les compter.
+ * @details Chaque sonde descend une seule branche de l'arbre de recherche,
+ * en tirant au hasard l'orientation de chaque case parmi celles qui
+ * résistent à la propagation ; le produit des nombres d'orientations
+ * possibles le long de la branche estime sans biais le nombre de solutions
+ * (estimateur de Knuth), les dernières pièces étant comptées exactement.
+ * Les sondes sont répétées jusqu'à ce que l'intervalle de confiance de leur
+ * moyenne (approximation normale) soit dans l'erreur relative demandée, ou
+ * jusqu'à épuisement du budget. Les sondes sont tirées avec un générateur
+ * propre : le résultat est le même d'un appel à l'autre. Un nombre déjà
+ * connu du cache, ou un jeu de quelques pièces, donne le nombre exact.
+ * @param g Le jeu à analyser.
+ * @param rel_error Demi-largeur voulue de l'intervalle, relative à
+ * l'estimation (par exemple 0.1 pour 10 %).
+ * @param confidence Niveau de confiance de l'intervalle, entre 0 et 1 exclus
+ * (par exemple 0.95).
+ * @param budget Nombre maximal de noeuds de recherche (0 : deux millions).
+ * @return L'estimation et son intervalle ; si aucune sonde n'atteint de
+ * solution, l'estimation et l'intervalle sont nuls. Si le budget est épuisé
+ * avant que l'intervalle atteigne l'erreur demandée, converged est faux, et
+ * avec une seule sonde la borne haute est infinie.
+ */
+game_estimate game_estimate_solutions(cgame g, double rel_error,
+                                      double confidence, uint64_t budget);
+
+/**
+ * @brief Résout le jeu dans les limites données, sans rien afficher.
+ * @param g Le jeu à résoudre, modifié seulement si une solution est trouvée.
+ * @param opts Les limites de la recherche (NULL : aucune).
+ * @param solved Reçoit true si une solution est trouvée.
+ * @return GAME_RUN_FINISHED si la recherche a abouti (avec ou sans
+ * solution), sinon la raison de l'arrêt.
+ */
+game_run_status game_solve_opts(game g, const game_solve_options* opts,
+                                bool* solved);
+
+/**
+ * @brief Résout le jeu en lançant plusieurs stratégies en parallèle.
+ * @details Aucune stratégie n'est la meilleure sur tous les jeux : chaque
+ * thread cherche avec sa propre configuration (retour arrière ligne par
+ * ligne, propagation, solveur SAT, puis propagation avec un ordre des cases
+ * et des orientations tiré au hasard) sur sa propre copie du jeu. La
+ * première à terminer arrête les autres, ce qui évite de dépendre d'un ordre
+ * malchanceux.
+ * @param g Le jeu à résoudre, modifié seulement si une solution est trouvée.
+ * @param nb_threads Nombre de configurations lancées, une par thread (0 pour
+ * utiliser tous les coeurs).
+ * @return true si une solution est trouvée, false sinon.
+ */
+bool game_solve_portfolio(game g, uint nb_threads);
+
+/**
+ * @brief Résout un grand jeu en le découpant en tuiles rectangulaires.
+ * @details Chaque tuile est remplie seule de toutes les façons possibles, les
+ * tuiles étant réparties sur plusieurs threads ; seules comptent, vues de
+ * l'extérieur, les demi-arêtes qui sortent de la tuile et la façon dont ses
+ * composantes les relient. Les classes qui ne s'accordent avec aucune classe
+ * d'une tuile voisine sur leur bord commun sont écartées, puis une recherche
+ * sur toute la grille, limitée aux orientations des classes restantes,
+ * vérifie la connexité de l'ensemble. Les classes des tuiles dont les formes
+ * n'ont pas changé depuis l'appel précédent sont réutilisées. Une tuile qui
+ * se remplit de trop de façons n'est pas restreinte.
+ * @param g Le jeu à résoudre, modifié seulement si une solution est trouvée.
+ * @param tile_size Côté des tuiles (0 pour la valeur par défaut, 4).
+ * @param nb_threads Nombre de threads (0 pour utiliser tous les coeurs).
+ * @return true si une solution est trouvée, false sinon.
+ */
+bool game_solve_tiled(game g, uint tile_size, uint nb_threads);
+
+/**
+ * @brief Résout un lot de jeux, de préférence petits.
+ * @details Les jeux de même taille (64 cases au plus) sont cherchés côte à
+ * côte, un jeu par voie, leurs données étant rangées case par case pour
+ * toutes les voies : les vérifications des demi-arêtes avancent au même pas
+ * sur toutes les voies, et une voie qui a terminé est simplement masquée.
+ * Les plus grands jeux sont résolus un par un.
+ * @param games Les jeux à résoudre, modifiés seulement si une solution est
+ * trouvée.
+ * @param nb_games Nombre de jeux.
+ * @param solved Reçoit pour chaque jeu true s'il est résolu (peut être
+ * NULL).
+ * @return Le nombre de jeux résolus.
+ */
+uint game_solve_batch(game* games, uint nb_games, bool* solved);
+
+/**
+ * @brief Cherche une solution par recherche locale, dans un temps donné.
+ * @details Pour les très grands jeux, où la recherche complète n'aboutit
+ * pas. En partant des orientations courantes, un recuit simulé tourne au
+ * hasard des pièces dont une demi-arête n'est pas appariée, parmi les
+ * orientations laissées par la propagation, chaque coup étant évalué en
+ * temps constant. Les zones autour des conflits restants et des composantes
+ * séparées sont ensuite résolues à nouveau par la recherche complète, en les
+ * agrandissant jusqu'à ce que le jeu soit gagné ou que le temps soit écoulé.
+ * @param g Le jeu, qui reçoit le meilleur état trouvé, solution ou non.
+ * @param time_limit Durée maximale, en secondes.
+ * @param nb_unmatched Reçoit le nombre de demi-arêtes non appariées de cet
+ * état (peut être NULL).
+ * @return true si le jeu est gagné, false sinon.
+ */
+bool game_solve_local(game g, double time_limit, uint* nb_unmatched);
+
+/**
+ * @brief Énumère toutes les solutions d'un jeu.
+ * @details Chaque solution est passée à cb sous la forme d'un tableau des
+ * orientations de toutes les cases, ligne par ligne (la case (i,j) est à
+ * l'indice i*nb_cols+j). Ce tableau n'est valable que pendant l'appel : il
+ * est modifié par la suite de la recherche, rien n'est recopié d'une solution
+ * à l'autre. Les solutions sont données à symétrie près, comme elles sont
+ * comptées par game_nb_solutions : une seule orientation par code de pièce
+ * (celle d'une case vide ou d'une CROSS est quelconque), si bien que les
+ * cases vides ne multiplient pas leur nombre. Le jeu n'est pas modifié.
+ * @param g Le jeu à analyser.
+ * @param cb Fonction appelée sur chaque solution, qui renvoie false pour
+ * arrêter l'énumération.
+ * @param ctx Pointeur transmis tel quel à cb.
+ * @return Le nombre de solutions passées à cb.
+ */
+uint64_t game_foreach_solution(cgame g,
+                               bool (*cb)(const direction* sol, void* ctx),
+                               void* ctx);
+
+/** Diagramme de décision de toutes les solutions d'un jeu (voir
+ * game_zdd_new). */
+typedef struct game_zdd_s* game_zdd;
+
+/**
+ * @brief Compile toutes les solutions d'un jeu en un diagramme de décision.
+ * @details Le diagramme est construit en un seul balayage de la grille, un
+ * niveau par case : chaque noeud a un fils par orientation distincte de sa
+ * case, et les noeuds équivalents sont partagés. Les questions posées
+ * ensuite (nombre de solutions, fraction des solutions où une case a une
+ * orientation donnée, solution tirée au hasard, cases imposées) prennent un
+ * temps linéaire en la taille du diagramme, sans nouvelle recherche. Comme
+ * pour game_foreach_solution, les solutions sont données à symétrie près.
+ * @param g Le jeu à compiler.
+ * @return Le diagramme, à détruire avec game_zdd_delete, ou NULL si le plus
+ * petit côté de la grille est trop long (plus de 14 cases, ou de 6 avec
+ * l'option wrapping).
+ */
+game_zdd game_zdd_new(cgame g);
+
+/**
+ * @brief Détruit un diagramme.
+ * @param z Le diagramme (NULL est accepté).
+ */
+void game_zdd_delete(game_zdd z);
+
+/**
+ * @brief Donne la taille d'un diagramme.
+ * @param z Le diagramme.
+ * @return Le nombre de noeuds, les deux terminaux compris.
+ */
+uint game_zdd_size(game_zdd z);
+
+/**
+ * @brief Donne le nombre de solutions d'un diagramme.
+ * @param z Le diagramme.
+ * @return Le nombre de solutions (modulo 2^64).
+ */
+uint64_t game_zdd_nb_solutions(game_zdd z);
+
+/**
+ * @brief Fraction des solutions où une case a une orientation donnée.
+ * @details Les orientations équivalentes de la pièce (même code) sont
+ * confondues.
+ * @param z Le diagramme.
+ * @param i Ligne de la case.
+ * @param j Colonne de la case.
+ * @param o L'orientation.
+ * @return La fraction, entre 0 et 1 (0 si le jeu n'a pas de solution).
+ */
+double game_zdd_fraction(game_zdd z, uint i, uint j, direction o);
+
+/**
+ * @brief Tire une solution uniformément au hasard (avec rand).
+ * @param z Le diagramme.
+ * @param g Un jeu de mêmes dimensions, option wrapping et formes que celui
+ * du diagramme, dont les pièces sont orientées selon la solution tirée.
+ * @return false si le jeu n'a pas de solution ou si g ne correspond pas au
+ * diagramme (g n'est alors pas modifié), true sinon.
+ */
+bool game_zdd_sample(game_zdd z, game g);
+
+/**
+ * @brief Donne les cases dont l'orientation est la même dans toutes les
+ * solutions.
+ * @param z Le diagramme.
+ * @param forced Reçoit, pour chaque case (i,j) à l'indice i*nb_cols+j, si
+ * son orientation est imposée.
+ * @param dirs Reçoit l'orientation des cases imposées.
+ * @return Le nombre de cases imposées (0 si le jeu n'a pas de solution).
+ */
+uint game_zdd_forced(game_zdd z, bool* forced, direction* dirs);
+
+/**
+ * @brief Sauvegarde un diagramme dans un fichier texte.
+ * @param z Le diagramme.
+ * @param filename Le nom du fichier.
+ * @return true si le fichier a été écrit, false sinon.
+ */
+bool game_zdd_save(game_zdd z, char* filename);
+
+/**
+ * @brief Charge un diagramme sauvegardé avec game_zdd_save.
+ * @param filename Le nom du fichier.
+ * @return Le diagramme, ou NULL si le fichier ne peut pas être lu ou ne
+ * contient pas un diagramme valide.
+ */
+game_zdd game_zdd_load(char* filename);
+
+/**
+ * @brief Donne un indice : une pièce à tourner et son orientation.
+ * @details La pièce est d'abord cherchée parmi celles dont l'orientation est
+ * imposée par propagation locale des contraintes, puis parmi celles dont une
+ * seule orientation résiste à la propagation. Ce n'est qu'en dernier recours
+ * qu'une solution est cherchée, avec un nombre de noeuds borné, et qu'une
+ * pièce orientée autrement que dans cette solution est donnée : cette pièce
+ * n'est pas forcément mal orientée dans toutes les solutions. Une fois la
+ * solution connue, les pièces dont l'orientation est imposée restent
+ * proposées d'abord. L'orientation proposée est la plus proche de l'actuelle
+ * dans le sens horaire. Les pièces du jeu ne sont pas tournées, mais l'état
+ * du solveur gardé avec le jeu est créé ou mis à jour, comme par game_solve :
+ * deux threads ne peuvent donc pas demander un indice sur le même jeu.
+ * @param g Le jeu à analyser.
+ * @param i Reçoit la ligne de la pièce.
+ * @param j Reçoit la colonne de la pièce.
+ * @param o Reçoit l'orientation à donner à la pièce.
+ * @return true si un indice est trouvé, false si le jeu est déjà résolu, n'a
+ * pas de solution ou si aucune solution n'est trouvée dans le nombre de
+ * noeuds permis (un appel suivant recommence alors la recherche).
+ */
+bool game_hint(game g, uint* i, uint* j, direction* o);
+
+/** Solveur pas à pas (voir game_solver_new). */
+typedef struct game_solver_s* game_solver;
+
+/** État d'un solveur pas à pas. */
+typedef enum {
+  GAME_SOLVER_RUNNING,     /**< la recherche n'est pas terminée */
+  GAME_SOLVER_SOLVED,      /**< une solution est trouvée */
+  GAME_SOLVER_NO_SOLUTION, /**< le jeu n'a pas de solution */
+} game_solver_state;
+
+/**
+ * @brief Crée un solveur qui avance par tranches de recherche.
+ * @details Toute la recherche (pile des décisions, domaines, composantes)
+ * est conservée d'un appel à game_solver_step au suivant, ce qui permet par
+ * exemple à une boucle d'affichage de chercher un peu à chaque image sans
+ * jamais se bloquer. Le solveur travaille sur sa propre copie du jeu, qui
+ * peut être modifié ou détruit ensuite.
+ * @param g Le jeu à résoudre.
+ * @return Le solveur, à détruire avec game_solver_delete.
+ */
+game_solver game_solver_new(cgame g);
+
+/**
+ * @brief Avance la recherche d'au plus max_nodes noeuds.
+ * @param s Le solveur.
+ * @param max_nodes Nombre maximal de noeuds de cette tranche (0 : aucune
+ * limite, la recherche va jusqu'au bout).
+ * @return L'état du solveur après cette tranche.
+ */
+game_solver_state game_solver_step(game_solver s, uint max_nodes);
+
+/**
+ * @brief Donne la meilleure affectation partielle trouvée jusqu'ici.
+ * @details Les pièces fixées dans la branche la plus profonde explorée (ou
+ * toutes celles de la solution, une fois trouvée) sont orientées dans g, les
+ * autres ne sont pas modifiées. Une pièce déjà dans une orientation
+ * équivalente n'est pas tournée.
+ * @param s Le solveur.
+ * @param g Un jeu de mêmes dimensions et formes que celui du solveur.
+ * @return Le nombre de pièces fixées.
+ */
+uint game_solver_best(game_solver s, game g);
+
+/**
+ * @brief Donne le nombre de noeuds explorés depuis la création du solveur.
+ * @param s Le solveur.
+ * @return Le nombre de noeuds.
+ */
+uint64_t game_solver_nb_nodes(game_solver s);
+
+/**
+ * @brief Détruit un solveur pas à pas.
+ * @param s Le solveur (NULL est accepté).
+ */
+void game_solver_delete(game_solver s);
+
 /**
  * @brief Résout le jeu en trouvant une configuration gagnante.
  * @param g Le jeu à résoudre.
@@ -149,4 +553,41 @@ uint game_nb_solutions(cgame g);
  */
 bool game_solve(game g);
 
+/**
+ * @brief Pré-traitement en temps linéaire, sans recherche.
+ * @details Vérifie des conditions nécessaires à l'existence d'une solution
+ * (nombre pair de demi-arêtes, au moins nb_pièces-1 arêtes, pas de pièces
+ * isolées des autres, y compris des ENDPOINT qui ne touchent que des
+ * ENDPOINT), et réduit les orientations possibles de chaque case à celles
+ * permises par le bord de la grille et par les voisins vides ou CROSS.
+ * game_solve et game_nb_solutions l'appliquent avant toute recherche.
+ * @param g Le jeu à analyser.
+ * @param f Fichier où écrire le rapport (nombre de pièces, de demi-arêtes,
+ * de pièces fixées, d'orientations écartées et verdict), ou NULL.
+ * @return false si le jeu n'a certainement pas de solution, true sinon.
+ */
+bool game_presolve(cgame g, FILE* f);
+
+/**
+ * @brief Résout le jeu avec le solveur SAT intégré.
+ * @details Le jeu est traduit en clauses (orientations et raccords des
+ * demi-arêtes), résolues par un solveur CDCL avec apprentissage de clauses.
+ * La connexité est ajoutée au fur et à mesure, par des coupes sur les
+ * composantes des modèles trouvés. Adapté aux grandes grilles peu
+ * contraintes.
+ * @param g Le jeu à résoudre.
+ * @return true si une solution est trouvée, false sinon.
+ */
+bool game_solve_sat(game g);
+
+/**
+ * @brief Écrit la traduction du jeu en clauses au format DIMACS.
+ * @details Les commentaires donnent la case et l'orientation, ou l'arête,
+ * de chaque variable. La connexité n'est pas encodée : elle doit être
+ * vérifiée sur les modèles trouvés par un solveur externe.
+ * @param g Le jeu à traduire.
+ * @param f Le fichier de destination.
+ */
+void game_export_dimacs(cgame g, FILE* f);
+
 /* GAME_TOOLS_H */
\ No newline at end of file
@@ -1,14 +1,21 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "game_tools.h"
 
 #include <assert.h>
+#include <dirent.h>
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "game.h"
 #include "game_aux.h"
 #include "game_ext.h"
 #include "game_private.h"
+#include "game_solver.h"
 #include "game_struct.h"
 #include "queue.h"
 
@@ -136,6 +143,805 @@ bool test_game_random() {
   return true;
 }
 
+// Fonction de test pour game_solve
+bool test_game_solve() {
+  game g = game_default();
+  bool ok = game_solve(g) && game_won(g);
+  game_delete(g);
+
+  // un jeu sans solution ne doit pas être modifié
+  game g1 = game_default();
+  game_set_piece_shape(g1, 0, 0, CROSS);
+  game g2 = game_copy(g1);
+  ok = ok && !game_solve(g1) && game_equal(g1, g2, false);
+  game_delete(g1);
+  game_delete(g2);
+  return ok;
+}
+
+// Fonction de test pour game_nb_solutions
+bool test_game_nb_solutions() {
+  game g = game_default();
+  bool ok = (game_nb_solutions(g) == 1);
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && (game_nb_solutions(g) == 0);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_nb_solutions_parallel
+bool test_game_nb_solutions_parallel() {
+  // tore 4x4 rempli de TEE : 268 solutions
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  game g = game_new_ext(4, 4, shapes, NULL, true);
+  bool ok = (game_nb_solutions(g) == 268);
+  for (uint nb_threads = 1; nb_threads <= 4; nb_threads++)
+    for (uint depth = 0; depth <= 16; depth += 4)
+      ok = ok && (game_nb_solutions_parallel(g, nb_threads, depth) == 268);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_nb_solutions_limit
+bool test_game_nb_solutions_limit() {
+  // tore 4x4 rempli de TEE : 268 solutions
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  game g = game_new_ext(4, 4, shapes, NULL, true);
+  bool ok = (game_nb_solutions_limit(g, 10) == 10) &&
+            (game_nb_solutions_limit(g, 268) == 268) &&
+            (game_nb_solutions_limit(g, 1000) == 268) &&
+            (game_nb_solutions_limit(g, 0) == 268);
+  game_delete(g);
+
+  // grille trop large pour le balayage : la recherche s'arrête à la limite
+  g = game_random(8, 8, true, 0, 20);
+  uint64_t nb_solutions = game_nb_solutions(g);
+  for (uint64_t limit = 1; limit <= 3; limit++)
+    ok = ok && (game_nb_solutions_limit(g, limit) ==
+                (nb_solutions < limit ? nb_solutions : limit));
+  game_delete(g);
+  return ok;
+}
+
+// compte les solutions énumérées par la recherche
+static bool _count_solution(const direction* sol, void* ctx) {
+  (void)sol;
+  (*(uint64_t*)ctx)++;
+  return true;
+}
+
+// le balayage de frontière et la recherche comptent-ils autant de solutions ?
+static bool _same_count(game g) {
+  solver* s = _solver_new(g);
+  bool ok = _solver_frontier_fits(s);
+  uint64_t nb_frontier = ok ? _solver_count_frontier(s) : 0;
+  _solver_delete(s);
+  uint64_t nb_search = 0;
+  game_foreach_solution(g, _count_solution, &nb_search);
+  return ok && nb_frontier == nb_search;
+}
+
+// Fonction de test pour le balayage de frontière de game_nb_solutions
+bool test_game_nb_solutions_frontier() {
+  // grilles étroites et longues, dans les deux sens, avec des cases vides
+  // et des arêtes en plus
+  uint dims[][2] = {{2, 9}, {9, 2}, {3, 7}, {7, 3}, {4, 6}};
+  bool ok = true;
+  for (uint k = 0; ok && k < 5; k++)
+    for (uint wrapping = 0; ok && wrapping <= 1; wrapping++)
+      for (uint seed = 0; ok && seed < 4; seed++) {
+        srand(seed);
+        game g = game_random(dims[k][0], dims[k][1], wrapping, seed % 3,
+                             2 * seed);
+        ok = g && _same_count(g);
+        if (g) game_delete(g);
+      }
+
+  // formes tirées au hasard (cases vides comprises) : le plus souvent sans
+  // solution, parfois avec plusieurs
+  shape shapes[18];
+  for (uint seed = 0; ok && seed < 200; seed++) {
+    srand(seed);
+    for (uint k = 0; k < 18; k++) shapes[k] = rand() % NB_SHAPES;
+    game g = game_new_ext(seed % 2 ? 3 : 6, seed % 2 ? 6 : 3, shapes, NULL,
+                          seed % 4 >= 2);
+    ok = _same_count(g);
+    game_delete(g);
+  }
+
+  // tore 3x6 rempli de TEE, avec beaucoup de solutions
+  for (uint k = 0; k < 18; k++) shapes[k] = TEE;
+  game g = game_new_ext(3, 6, shapes, NULL, true);
+  ok = ok && _same_count(g);
+  game_delete(g);
+
+  // une seule colonne ou une seule ligne, torique ou non : chaque case est
+  // sa propre voisine sur le tore
+  shape line[6] = {ENDPOINT, SEGMENT, SEGMENT, ENDPOINT, EMPTY, EMPTY};
+  shape ring[6] = {SEGMENT, SEGMENT, SEGMENT, SEGMENT, SEGMENT, SEGMENT};
+  shape tees[6] = {TEE, ENDPOINT, TEE, ENDPOINT, CROSS, EMPTY};
+  shape* lines[3] = {line, ring, tees};
+  for (uint k = 0; ok && k < 3; k++)
+    for (uint wrapping = 0; ok && wrapping <= 1; wrapping++) {
+      g = game_new_ext(6, 1, lines[k], NULL, wrapping);
+      ok = _same_count(g);
+      game_delete(g);
+      g = game_new_ext(1, 6, lines[k], NULL, wrapping);
+      ok = ok && _same_count(g);
+      game_delete(g);
+    }
+  return ok;
+}
+
+// Fonction de test pour game_has_unique_solution
+bool test_game_has_unique_solution() {
+  game g = game_default();
+  bool ok = game_has_unique_solution(g);
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && !game_has_unique_solution(g);
+  game_delete(g);
+
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  g = game_new_ext(4, 4, shapes, NULL, true);
+  ok = ok && !game_has_unique_solution(g);
+  game_delete(g);
+  return ok;
+}
+
+// compte les solutions gagnantes, et s'arrête après max d'entre elles
+typedef struct {
+  game g;
+  uint nb_won;
+  uint max;
+} foreach_ctx;
+
+static bool _check_solution(const direction* sol, void* ctx) {
+  foreach_ctx* c = (foreach_ctx*)ctx;
+  uint nb_cols = game_nb_cols(c->g);
+  for (uint i = 0; i < game_nb_rows(c->g); i++)
+    for (uint j = 0; j < nb_cols; j++)
+      game_set_piece_orientation(c->g, i, j, sol[i * nb_cols + j]);
+  if (game_won(c->g)) c->nb_won++;
+  return c->nb_won < c->max;
+}
+
+// Fonction de test pour game_foreach_solution
+bool test_game_foreach_solution() {
+  // tore 4x4 rempli de TEE : 268 solutions
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  game g = game_new_ext(4, 4, shapes, NULL, true);
+  foreach_ctx ctx = {game_copy(g), 0, 1000};
+  bool ok = (game_foreach_solution(g, _check_solution, &ctx) == 268) &&
+            (ctx.nb_won == 268);
+
+  // l'énumération s'arrête dès que la fonction renvoie false
+  ctx.nb_won = 0;
+  ctx.max = 5;
+  ok = ok && (game_foreach_solution(g, _check_solution, &ctx) == 5) &&
+       (ctx.nb_won == 5);
+  game_delete(ctx.g);
+  game_delete(g);
+
+  // un jeu sans solution
+  g = game_default();
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ctx.g = game_copy(g);
+  ctx.nb_won = 0;
+  ok = ok && (game_foreach_solution(g, _check_solution, &ctx) == 0) &&
+       (ctx.nb_won == 0);
+  game_delete(ctx.g);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_hint
+bool test_game_hint() {
+  // en suivant les indices, on arrive à la solution
+  game g = game_default();
+  uint i, j, nb_hints = 0;
+  direction o;
+  bool ok = true;
+  while (ok && !game_won(g) && nb_hints <= 25) {
+    ok = game_hint(g, &i, &j, &o) && i < 5 && j < 5 &&
+         game_get_piece_orientation(g, i, j) != o;
+    if (ok) game_set_piece_orientation(g, i, j, o);
+    nb_hints++;
+  }
+  ok = ok && game_won(g) && !game_hint(g, &i, &j, &o);
+  game_delete(g);
+
+  // pas d'indice sans solution
+  g = game_default();
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && !game_hint(g, &i, &j, &o);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_cache_set_dir et game_cache_clear
+bool test_game_cache() {
+  // le même jeu, mélangé : la solution et le compte viennent du cache
+  game g = game_default();
+  bool ok = (game_nb_solutions(g) == 1) && game_solve(g) && game_won(g);
+  game_shuffle_orientation(g);
+  ok = ok && (game_nb_solutions(g) == 1) && game_solve(g) && game_won(g);
+
+  // une autre grille n'est pas confondue avec la première
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && (game_nb_solutions(g) == 0) && !game_solve(g);
+  game_delete(g);
+
+  // avec un répertoire, les résultats survivent à game_cache_clear
+  char dir[] = "/tmp/game_cacheXXXXXX";
+  if (!mkdtemp(dir)) return false;
+  game_cache_set_dir(dir);
+  game_cache_clear();
+  g = game_default();
+  ok = ok && (game_nb_solutions(g) == 1);
+  game_cache_clear();
+  ok = ok && (game_nb_solutions(g) == 1) && game_solve(g) && game_won(g);
+  game_delete(g);
+  game_cache_set_dir(NULL);
+
+  // un seul fichier pour la grille, supprimé ensuite
+  uint nb_files = 0;
+  DIR* d = opendir(dir);
+  struct dirent* entry;
+  char path[sizeof(dir) + 256];
+  while (d && (entry = readdir(d))) {
+    if (entry->d_name[0] == '.') continue;
+    nb_files++;
+    snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+    remove(path);
+  }
+  if (d) closedir(d);
+  rmdir(dir);
+  return ok && nb_files == 1;
+}
+
+// Fonction de test pour game_presolve
+bool test_game_presolve() {
+  game g = game_default();
+  bool ok = game_presolve(g, NULL);
+
+  // un CROSS dans un coin n'a aucune orientation possible
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && !game_presolve(g, NULL);
+  game_delete(g);
+
+  // nombre impair de demi-arêtes : un TEE et un ENDPOINT
+  shape shapes[4] = {TEE, ENDPOINT, EMPTY, EMPTY};
+  g = game_new_ext(2, 2, shapes, NULL, false);
+  ok = ok && !game_presolve(g, NULL);
+  game_delete(g);
+
+  // deux paires d'ENDPOINT séparées par des cases vides
+  shape pairs[6] = {ENDPOINT, ENDPOINT, EMPTY, EMPTY, ENDPOINT, ENDPOINT};
+  g = game_new_ext(3, 2, pairs, NULL, false);
+  ok = ok && !game_presolve(g, NULL);
+  game_delete(g);
+
+  // un ENDPOINT qui ne touche que des ENDPOINT
+  shape ends[6] = {ENDPOINT, ENDPOINT, CORNER, ENDPOINT, TEE, CORNER};
+  g = game_new_ext(2, 3, ends, NULL, false);
+  FILE* f = tmpfile();
+  if (!f) return false;
+  ok = ok && !game_presolve(g, f) && game_nb_solutions(g) == 0;
+  game_delete(g);
+
+  // le rapport se termine par le verdict
+  char line[256], last[256] = "";
+  rewind(f);
+  while (fgets(line, sizeof(line), f)) strcpy(last, line);
+  fclose(f);
+  return ok && strncmp(last, "status: pieces", 14) == 0;
+}
+
+static void _count_progress(uint64_t nb_nodes, uint depth, void* ctx) {
+  (void)nb_nodes;
+  (void)depth;
+  (*(uint*)ctx)++;
+}
+
+// Fonction de test pour game_solve_opts et game_nb_solutions_opts
+bool test_game_solve_opts() {
+  // sans limite, même résultat que game_solve
+  game g = game_default();
+  bool solved = false;
+  bool ok = (game_solve_opts(g, NULL, &solved) == GAME_RUN_FINISHED) &&
+            solved && game_won(g);
+  game_delete(g);
+
+  // tore 10x10 rempli de TEE : trop large pour le balayage, avec un très
+  // grand nombre de solutions
+  shape shapes[100];
+  for (uint k = 0; k < 100; k++) shapes[k] = TEE;
+  g = game_new_ext(10, 10, shapes, NULL, true);
+  uint nb_calls = 0;
+  game_solve_options opts = {0, 1000, NULL, _count_progress, 100, &nb_calls};
+  uint64_t nb_solutions;
+  ok = ok && (game_nb_solutions_opts(g, &opts, &nb_solutions) ==
+              GAME_RUN_NODE_LIMIT) &&
+       nb_calls == 10;
+
+  game_solve_options timeout = {0.05, 0, NULL, NULL, 0, NULL};
+  ok = ok && (game_nb_solutions_opts(g, &timeout, &nb_solutions) ==
+              GAME_RUN_TIMEOUT);
+
+  // une recherche annulée ne modifie pas le jeu
+  volatile bool cancel = true;
+  game_solve_options cancelled = {0, 0, &cancel, NULL, 0, NULL};
+  game_shuffle_orientation(g);
+  game g2 = game_copy(g);
+  ok = ok && (game_nb_solutions_opts(g, &cancelled, &nb_solutions) ==
+              GAME_RUN_CANCELLED) &&
+       (game_solve_opts(g, &cancelled, &solved) == GAME_RUN_CANCELLED) &&
+       !solved && game_equal(g, g2, false);
+  game_delete(g);
+  game_delete(g2);
+
+  // tore 4x10 : assez étroit pour le balayage, qui ne sait pas s'arrêter ;
+  // les limites passent donc par la recherche
+  game_cache_clear();
+  g = game_new_ext(4, 10, shapes, NULL, true);
+  game_solve_options few_nodes = {0, 10, NULL, NULL, 0, NULL};
+  ok = ok && (game_nb_solutions_opts(g, &cancelled, &nb_solutions) ==
+              GAME_RUN_CANCELLED) &&
+       (game_nb_solutions_opts(g, &few_nodes, &nb_solutions) ==
+        GAME_RUN_NODE_LIMIT) &&
+       nb_solutions < game_nb_solutions(g);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_solver_new et game_solver_step
+bool test_game_solver_step() {
+  // le jeu par défaut, par petites tranches
+  game g = game_default();
+  game_solver gs = game_solver_new(g);
+  game_solver_state state;
+  while ((state = game_solver_step(gs, 5)) == GAME_SOLVER_RUNNING) {
+  }
+  bool ok = state == GAME_SOLVER_SOLVED &&
+            game_solver_best(gs, g) == game_nb_rows(g) * game_nb_cols(g) &&
+            game_won(g);
+  game_solver_delete(gs);
+  game_delete(g);
+
+  // tore 10x10 de TEE : la recherche découpée en tranches de 7 noeuds
+  // explore exactement les mêmes noeuds qu'en une seule fois
+  shape shapes[100];
+  for (uint k = 0; k < 100; k++) shapes[k] = TEE;
+  game g1 = game_new_ext(10, 10, shapes, NULL, true);
+  game_shuffle_orientation(g1);
+  game g2 = game_copy(g1);
+  game_solver gs1 = game_solver_new(g1);
+  game_solver gs2 = game_solver_new(g2);
+  uint nb_steps = 0, best = 0;
+  while (game_solver_step(gs1, 7) == GAME_SOLVER_RUNNING) {
+    // la meilleure affectation partielle ne fait que s'étendre
+    uint nb_fixed = game_solver_best(gs1, g1);
+    ok = ok && nb_fixed >= best;
+    best = nb_fixed;
+    nb_steps++;
+  }
+  ok = ok && nb_steps > 0 &&
+       game_solver_step(gs2, 0) == GAME_SOLVER_SOLVED &&
+       game_solver_step(gs1, 7) == GAME_SOLVER_SOLVED &&
+       game_solver_nb_nodes(gs1) == game_solver_nb_nodes(gs2) &&
+       game_solver_best(gs1, g1) == 100 && game_solver_best(gs2, g2) == 100 &&
+       game_won(g1) && game_equal(g1, g2, false);
+  game_solver_delete(gs1);
+  game_solver_delete(gs2);
+  game_delete(g1);
+  game_delete(g2);
+
+  // un jeu sans solution
+  g = game_default();
+  game_set_piece_shape(g, 0, 0, CROSS);
+  gs = game_solver_new(g);
+  while ((state = game_solver_step(gs, 5)) == GAME_SOLVER_RUNNING) {
+  }
+  ok = ok && state == GAME_SOLVER_NO_SOLUTION;
+  game_solver_delete(gs);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test de la reprise d'une résolution après quelques coups
+bool test_game_solve_warm() {
+  game g = game_default();
+  bool ok = game_solve(g) && game_won(g);
+
+  // quelques coups, annulés puis rejoués : la solution gardée avec le jeu
+  // est remise en place
+  game_play_move(g, 0, 0, 1);
+  game_play_move(g, 2, 3, 2);
+  game_play_move(g, 4, 4, -1);
+  game_undo(g);
+  ok = ok && !game_won(g) && game_solve(g) && game_won(g);
+  game_play_move(g, 1, 1, 1);
+  game_undo(g);
+  game_redo(g);
+  direction o33 = game_get_piece_orientation(g, 3, 3);
+  game_set_piece_orientation(g, 3, 3, (o33 + 1) % NB_DIRS);
+
+  // les indices ne désignent que les pièces tournées depuis
+  uint i, j, nb_hints = 0;
+  direction o;
+  while (ok && !game_won(g) && nb_hints < 2) {
+    ok = game_hint(g, &i, &j, &o) &&
+         ((i == 1 && j == 1) || (i == 3 && j == 3));
+    if (ok) game_set_piece_orientation(g, i, j, o);
+    nb_hints++;
+  }
+  ok = ok && game_won(g) && !game_hint(g, &i, &j, &o);
+
+  // changer une forme oublie la solution
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && !game_solve(g) && !game_hint(g, &i, &j, &o);
+  game_delete(g);
+
+  // tore d'une seule colonne : chaque case est sa propre voisine à l'est et
+  // à l'ouest, le décompte des demi-arêtes non appariées reste exact
+  shape col[3] = {ENDPOINT, SEGMENT, ENDPOINT};
+  g = game_new_ext(3, 1, col, NULL, true);
+  ok = ok && game_solve(g) && game_won(g);
+  for (uint k = 0; ok && k < 12; k++) {
+    game_play_move(g, k % 3, 0, (k % 2) ? 1 : -1);
+    solver_warm* w = _solver_warm_new(g);
+    ok = g->warm->nb_mismatch == w->nb_mismatch;
+    _solver_warm_delete(w);
+  }
+  ok = ok && game_solve(g) && game_won(g) && g->warm->nb_mismatch == 0;
+  game_delete(g);
+
+  // l'état créé par un indice ne dispense pas des limites d'une recherche
+  g = game_random(40, 40, true, 0, 0);
+  game_shuffle_orientation(g);
+  ok = ok && game_hint(g, &i, &j, &o);
+  game g2 = game_copy(g);
+  volatile bool cancel = true;
+  game_solve_options cancelled = {0.01, 0, &cancel, NULL, 0, NULL};
+  bool solved = true;
+  ok = ok && (game_solve_opts(g, &cancelled, &solved) == GAME_RUN_CANCELLED) &&
+       !solved && game_equal(g, g2, false);
+  ok = ok && game_solve(g) && game_won(g);
+  game_delete(g);
+  game_delete(g2);
+  return ok;
+}
+
+// Fonction de test pour game_solve_portfolio
+bool test_game_solve_portfolio() {
+  game g = game_default();
+  bool ok = game_solve_portfolio(g, 4) && game_won(g);
+  game_delete(g);
+
+  // tore 10x10 rempli de TEE, avec toutes les configurations et plus
+  shape shapes[100];
+  for (uint k = 0; k < 100; k++) shapes[k] = TEE;
+  for (uint nb_threads = 1; nb_threads <= 6; nb_threads++) {
+    g = game_new_ext(10, 10, shapes, NULL, true);
+    game_shuffle_orientation(g);
+    ok = ok && game_solve_portfolio(g, nb_threads) && game_won(g);
+    game_delete(g);
+    game_cache_clear();
+  }
+
+  // un jeu sans solution ne doit pas être modifié
+  game g1 = game_default();
+  game_set_piece_shape(g1, 0, 0, CROSS);
+  game g2 = game_copy(g1);
+  ok = ok && !game_solve_portfolio(g1, 0) && game_equal(g1, g2, false);
+  game_delete(g1);
+  game_delete(g2);
+  return ok;
+}
+
+// Fonction de test pour game_solve_batch
+bool test_game_solve_batch() {
+  // des jeux de plusieurs tailles mélangées, dont un trop grand pour les
+  // voies et un sans solution
+  game games[40];
+  bool solved[40];
+  uint nb_games = 0;
+  for (uint k = 0; k < 36; k++) {
+    games[nb_games] = game_random(5 + k % 3, 5 + k % 2, k % 4 == 0, 1, 1);
+    if (games[nb_games]) game_shuffle_orientation(games[nb_games++]);
+  }
+  games[nb_games++] = game_default();
+  games[nb_games] = game_default();
+  game_set_piece_shape(games[nb_games++], 0, 0, CROSS);
+  shape shapes[100];
+  for (uint k = 0; k < 100; k++) shapes[k] = TEE;
+  games[nb_games++] = game_new_ext(10, 10, shapes, NULL, true);
+
+  uint nb_solved = game_solve_batch(games, nb_games, solved);
+  bool ok = nb_solved == nb_games - 1;
+  for (uint k = 0; k < nb_games; k++) {
+    ok = ok && solved[k] == game_won(games[k]) &&
+         (solved[k] || k == nb_games - 2);
+    game_delete(games[k]);
+  }
+  return ok;
+}
+
+// Fonction de test pour la recherche sur bitboard (64 cases au plus)
+bool test_game_solve_bitboard() {
+  bool ok = true;
+  // tores trop larges pour le balayage de frontière : le compte vient du
+  // bitboard, l'énumération de la recherche avec propagation
+  for (uint k = 0; k < 12 && ok; k++) {
+    game g = game_random(7 + k % 2, 8 - k % 2, true, k % 4, k % 3);
+    if (!g) continue;
+    if (k % 3 == 0) game_set_piece_shape(g, k % 7, 0, SEGMENT);
+    game_shuffle_orientation(g);
+    foreach_ctx ctx = {game_copy(g), 0, UINT_MAX};
+    uint nb_solutions = game_nb_solutions(g);
+    ok = game_foreach_solution(g, _check_solution, &ctx) == nb_solutions &&
+         ctx.nb_won == nb_solutions;
+    game_delete(ctx.g);
+    game_delete(g);
+  }
+
+  // résolution sans et avec bouclage, y compris sur une seule ligne ou une
+  // seule colonne, où une case est sa propre voisine
+  uint sizes[][2] = {{5, 5}, {1, 8}, {8, 1}, {4, 16}, {8, 8}, {2, 3}};
+  for (uint k = 0; k < 24 && ok; k++) {
+    uint nb_rows = sizes[k % 6][0], nb_cols = sizes[k % 6][1];
+    game g = game_random(nb_rows, nb_cols, k % 2 == 1, k % 3, 1);
+    if (!g) continue;
+    if (k % 5 == 0) game_set_piece_shape(g, 0, 0, CROSS);
+    game_shuffle_orientation(g);
+    game h = game_copy(g);
+    bool solved = game_solve(h);
+    ok = solved == (game_nb_solutions(g) > 0) && solved == game_won(h);
+    game_delete(g);
+    game_delete(h);
+  }
+  game_cache_clear();
+  return ok;
+}
+
+// Fonction de test pour game_solve_local
+bool test_game_solve_local() {
+  bool ok = true;
+  uint nb_unmatched = UINT_MAX;
+  for (uint k = 0; k < 6 && ok; k++) {
+    game g = (k == 0) ? game_default()
+                      : game_random(10 * k, 12 * k, k % 2 == 0, k % 3, 1);
+    if (!g) continue;
+    game_shuffle_orientation(g);
+    ok = game_solve_local(g, 10.0, &nb_unmatched) && game_won(g) &&
+         nb_unmatched == 0;
+    game_delete(g);
+  }
+
+  // jeu sans solution : le meilleur état trouvé est gardé, dans le temps
+  // donné
+  game g = game_default();
+  game_set_piece_shape(g, 0, 0, CROSS);
+  ok = ok && !game_solve_local(g, 0.2, &nb_unmatched) && nb_unmatched > 0 &&
+       !game_is_well_paired(g);
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_solve_tiled
+bool test_game_solve_tiled() {
+  bool ok = true;
+  for (uint k = 1; k < 6 && ok; k++) {
+    game g = game_random(6 + 3 * k, 5 + 4 * k, k % 2 == 0, k % 3, k % 2);
+    if (!g) continue;
+    game_shuffle_orientation(g);
+    ok = game_solve_tiled(g, (k % 2 == 0) ? 0 : 5, k) && game_won(g);
+
+    // une arête de plus près d'un coin : seules les tuiles qui la touchent
+    // sont remplies à nouveau
+    uint i = game_nb_rows(g) - 1, j = game_nb_cols(g) - 1;
+    bool added = false;
+    for (direction d = 0; d < NB_DIRS && !added; d++)
+      added = _add_edge(g, i - 1, j - 1, d);
+    game_shuffle_orientation(g);
+    ok = ok && game_solve_tiled(g, (k % 2 == 0) ? 0 : 5, k) && game_won(g);
+
+    // le même coin devient une croix : plus aucune solution
+    if (!game_is_wrapping(g)) {
+      game_set_piece_shape(g, i, j, CROSS);
+      ok = ok && !game_solve_tiled(g, (k % 2 == 0) ? 0 : 5, k);
+    }
+    game_delete(g);
+  }
+
+  // jeu sans solution : il ne doit pas être modifié
+  game g1 = game_random(12, 12, false, 0, 0);
+  if (!g1) return ok;
+  game_set_piece_shape(g1, 0, 0, CROSS);
+  game g2 = game_copy(g1);
+  ok = ok && !game_solve_tiled(g1, 4, 2) && game_equal(g1, g2, false);
+  game_delete(g1);
+  game_delete(g2);
+  game_cache_clear();
+  return ok;
+}
+
+// Fonction de test pour game_zdd_new et les requêtes sur le diagramme
+bool test_game_zdd() {
+  bool ok = true;
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  for (uint k = 0; k < 4 && ok; k++) {
+    // jeu par défaut, tore 4x4 rempli de TEE, puis jeux aléatoires
+    game g = (k == 0)   ? game_default()
+             : (k == 1) ? game_new_ext(4, 4, shapes, NULL, true)
+                        : game_random(3 + k, 6, k == 3, 1, 2);
+    if (!g) continue;
+    game_zdd z = game_zdd_new(g);
+    uint nb_solutions = game_nb_solutions(g);
+    ok = z && game_zdd_nb_solutions(z) == nb_solutions &&
+         game_zdd_size(z) >= 2;
+
+    // pour chaque case, les fractions des orientations distinctes font 1
+    uint nb_rows = game_nb_rows(g), nb_cols = game_nb_cols(g);
+    for (uint c = 0; c < nb_rows * nb_cols && ok; c++) {
+      shape sh = game_get_piece_shape(g, c / nb_cols, c % nb_cols);
+      double sum = 0.0;
+      for (direction o = 0; o < NB_DIRS; o++) {
+        bool distinct = true;
+        for (direction p = 0; p < o; p++)
+          if (_code[sh][p] == _code[sh][o]) distinct = false;
+        if (distinct) sum += game_zdd_fraction(z, c / nb_cols, c % nb_cols, o);
+      }
+      ok = sum > 0.999999 && sum < 1.000001;
+    }
+
+    // une solution tirée au hasard, dont les cases imposées ont
+    // l'orientation donnée
+    bool forced[36];
+    direction dirs[36];
+    uint nb_forced = game_zdd_forced(z, forced, dirs);
+    game h = game_copy(g);
+    game_shuffle_orientation(h);
+    ok = ok && game_zdd_sample(z, h) && game_won(h);
+    for (uint c = 0; c < nb_rows * nb_cols && ok; c++) {
+      shape sh = game_get_piece_shape(h, c / nb_cols, c % nb_cols);
+      direction o = game_get_piece_orientation(h, c / nb_cols, c % nb_cols);
+      ok = !forced[c] || _code[sh][o] == _code[sh][dirs[c]];
+    }
+    ok = ok && (nb_solutions != 1 || nb_forced == nb_rows * nb_cols);
+
+    // le diagramme relu donne les mêmes réponses
+    ok = ok && game_zdd_save(z, "test_game_zdd.txt");
+    game_zdd z2 = game_zdd_load("test_game_zdd.txt");
+    remove("test_game_zdd.txt");
+    ok = ok && z2 && game_zdd_nb_solutions(z2) == nb_solutions &&
+         game_zdd_size(z2) == game_zdd_size(z) &&
+         game_zdd_fraction(z2, 0, 0, NORTH) ==
+             game_zdd_fraction(z, 0, 0, NORTH);
+    game_zdd_delete(z);
+    game_zdd_delete(z2);
+    game_delete(g);
+    game_delete(h);
+  }
+
+  // jeu sans solution : diagramme vide, rien à tirer
+  game g = game_default();
+  game_set_piece_shape(g, 0, 0, CROSS);
+  game h = game_copy(g);
+  game_zdd z = game_zdd_new(g);
+  bool forced[25];
+  direction dirs[25];
+  ok = ok && z && game_zdd_nb_solutions(z) == 0 && game_zdd_size(z) == 2 &&
+       !game_zdd_sample(z, g) && game_equal(g, h, false) &&
+       game_zdd_forced(z, forced, dirs) == 0;
+  game_zdd_delete(z);
+  game_delete(g);
+  game_delete(h);
+
+  // un fichier qui n'est pas un diagramme est refusé
+  FILE* f = fopen("test_game_zdd.txt", "w");
+  if (!f) return false;
+  fprintf(f, "2 2 0\n1 1\n1 1\n0 1 2 3\n3 2\n0 1 0 0 0\n");
+  fclose(f);
+  ok = ok && game_zdd_load("test_game_zdd.txt") == NULL;
+  remove("test_game_zdd.txt");
+  return ok;
+}
+
+// Fonction de test pour game_estimate_solutions
+bool test_game_estimate_solutions() {
+  // tore 4x4 rempli de TEE : 268 solutions
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  game g = game_new_ext(4, 4, shapes, NULL, true);
+  game_cache_clear();
+  game_estimate e = game_estimate_solutions(g, 0.1, 0.99, 0);
+  game_estimate small = game_estimate_solutions(g, 0.0, 0.95, 100);
+  game_estimate one = game_estimate_solutions(g, 0.1, 0.95, 1);
+  uint nb_solutions = game_nb_solutions(g);
+  bool ok = !e.exact && e.converged && e.nb_probes >= 2 &&
+            e.low <= nb_solutions && nb_solutions <= e.high &&
+            e.low <= e.estimate && e.estimate <= e.high;
+
+  // le budget limite le nombre de sondes, l'estimation n'a pas convergé ;
+  // une seule sonde ne borne pas l'intervalle
+  ok = ok && small.nb_probes > 0 && small.nb_probes < e.nb_probes &&
+       !small.converged;
+  ok = ok && one.nb_probes == 1 && !one.converged && isinf(one.high) &&
+       one.low <= one.estimate;
+
+  // une fois compté, le nombre exact est lu dans le cache
+  e = game_estimate_solutions(g, 0.1, 0.99, 0);
+  ok = ok && e.exact && e.estimate == nb_solutions;
+  game_delete(g);
+
+  // jeu par défaut : solution unique, trouvée par les sondes
+  g = game_default();
+  e = game_estimate_solutions(g, 0.1, 0.95, 0);
+  ok = ok && e.low == 1.0 && e.high >= 1.0;
+  game_delete(g);
+
+  // jeu sans solution : nombre exact, nul
+  g = game_default();
+  game_set_piece_shape(g, 0, 0, CROSS);
+  e = game_estimate_solutions(g, 0.1, 0.95, 0);
+  ok = ok && e.exact && e.estimate == 0.0 && e.high == 0.0;
+  game_delete(g);
+  return ok;
+}
+
+// Fonction de test pour game_solve_sat
+bool test_game_solve_sat() {
+  game g = game_default();
+  bool ok = game_solve_sat(g) && game_won(g);
+  game_delete(g);
+
+  // tore 4x4 rempli de TEE : la connexité demande des coupes
+  shape shapes[16];
+  for (uint k = 0; k < 16; k++) shapes[k] = TEE;
+  g = game_new_ext(4, 4, shapes, NULL, true);
+  ok = ok && game_solve_sat(g) && game_won(g);
+  game_delete(g);
+
+  // un jeu sans solution ne doit pas être modifié
+  game g1 = game_default();
+  game_set_piece_shape(g1, 0, 0, CROSS);
+  game g2 = game_copy(g1);
+  ok = ok && !game_solve_sat(g1) && game_equal(g1, g2, false);
+  game_delete(g1);
+  game_delete(g2);
+  return ok;
+}
+
+// Fonction de test pour game_export_dimacs
+bool test_game_export_dimacs() {
+  game g = game_default();
+  FILE* f = tmpfile();
+  if (!f) return false;
+  game_export_dimacs(g, f);
+  game_delete(g);
+  rewind(f);
+
+  // l'en-tête annonce autant de clauses qu'il y en a dans le fichier
+  char line[256];
+  uint nb_vars = 0, nb_clauses = 0, nb_lines = 0;
+  bool header = false;
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == 'c') continue;
+    if (line[0] == 'p')
+      header = (sscanf(line, "p cnf %u %u", &nb_vars, &nb_clauses) == 2);
+    else
+      nb_lines++;
+  }
+  fclose(f);
+  return header && nb_vars > 0 && nb_clauses > 0 && nb_lines == nb_clauses;
+}
+
 int main(int argc, char* argv[]) {
   if (argc == 1) {
     return EXIT_FAILURE;
@@ -148,6 +954,50 @@ int main(int argc, char* argv[]) {
     ok = test_game_save();
   else if (strcmp("game_random", argv[1]) == 0)
     ok = test_game_random();
+  else if (strcmp("game_solve", argv[1]) == 0)
+    ok = test_game_solve();
+  else if (strcmp("game_nb_solutions", argv[1]) == 0)
+    ok = test_game_nb_solutions();
+  else if (strcmp("game_nb_solutions_parallel", argv[1]) == 0)
+    ok = test_game_nb_solutions_parallel();
+  else if (strcmp("game_nb_solutions_limit", argv[1]) == 0)
+    ok = test_game_nb_solutions_limit();
+  else if (strcmp("game_nb_solutions_frontier", argv[1]) == 0)
+    ok = test_game_nb_solutions_frontier();
+  else if (strcmp("game_has_unique_solution", argv[1]) == 0)
+    ok = test_game_has_unique_solution();
+  else if (strcmp("game_foreach_solution", argv[1]) == 0)
+    ok = test_game_foreach_solution();
+  else if (strcmp("game_hint", argv[1]) == 0)
+    ok = test_game_hint();
+  else if (strcmp("game_cache", argv[1]) == 0)
+    ok = test_game_cache();
+  else if (strcmp("game_presolve", argv[1]) == 0)
+    ok = test_game_presolve();
+  else if (strcmp("game_solve_opts", argv[1]) == 0)
+    ok = test_game_solve_opts();
+  else if (strcmp("game_solve_batch", argv[1]) == 0)
+    ok = test_game_solve_batch();
+  else if (strcmp("game_solve_portfolio", argv[1]) == 0)
+    ok = test_game_solve_portfolio();
+  else if (strcmp("game_solve_bitboard", argv[1]) == 0)
+    ok = test_game_solve_bitboard();
+  else if (strcmp("game_solve_local", argv[1]) == 0)
+    ok = test_game_solve_local();
+  else if (strcmp("game_solve_tiled", argv[1]) == 0)
+    ok = test_game_solve_tiled();
+  else if (strcmp("game_zdd", argv[1]) == 0)
+    ok = test_game_zdd();
+  else if (strcmp("game_estimate_solutions", argv[1]) == 0)
+    ok = test_game_estimate_solutions();
+  else if (strcmp("game_solve_warm", argv[1]) == 0)
+    ok = test_game_solve_warm();
+  else if (strcmp("game_solver_step", argv[1]) == 0)
+    ok = test_game_solver_step();
+  else if (strcmp("game_solve_sat", argv[1]) == 0)
+    ok = test_game_solve_sat();
+  else if (strcmp("game_export_dimacs", argv[1]) == 0)
+    ok = test_game_export_dimacs();
   else {
     fprintf(stderr, "Error: test \"%s\" not found!\n", argv[1]);
     exit(EXIT_FAILURE);
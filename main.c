@@ -42,6 +42,9 @@ int main(int argc, char* argv[]) {
       if (quit) break;
     }
 
+    /* advance background work (e.g. the solver) by one slice */
+    update(win, ren, env);
+
     /* background in gray */
     SDL_SetRenderDrawColor(ren, 0xA0, 0xA0, 0xA0, 0xFF);
     SDL_RenderClear(ren);
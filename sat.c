@@ -0,0 +1,582 @@
+#include "sat.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* *********************************************************** */
+
+#define VAR_DECAY 0.95
+#define CLAUSE_DECAY 0.999
+#define RESTART_BASE 100
+
+/* Internal literals: 2*v for variable v (0-based), 2*v+1 for its negation.
+ * Values: 1 (true), -1 (false), 0 (unassigned). */
+
+typedef struct {
+  int size;
+  bool learnt;
+  double activity;
+  int lits[];
+} clause;
+
+/** growable array of clauses */
+typedef struct {
+  clause** data;
+  int len;
+  int capacity;
+} clause_vec;
+
+struct sat_s {
+  int nb_vars;
+  bool ok;              /* false once the clauses are known unsatisfiable */
+  clause_vec clauses;   /* problem clauses */
+  clause_vec learnts;   /* learnt clauses */
+  clause_vec* watches;  /* watches[l]: clauses watching literal l */
+  signed char* values;  /* value of each variable */
+  int* levels;          /* decision level of each variable */
+  clause** reasons;     /* clause that implied each variable */
+  int* trail;           /* assigned literals, in order */
+  int trail_len;
+  int* trail_lim;       /* start of each decision level in the trail */
+  int nb_levels;
+  int qhead;            /* next literal of the trail to propagate */
+  double* activity;     /* VSIDS activity of each variable */
+  double var_inc;
+  double clause_inc;
+  int* heap;            /* unassigned variables, by decreasing activity */
+  int* heap_pos;        /* position in the heap (-1 if absent) */
+  int heap_len;
+  signed char* phase;   /* last polarity of each variable */
+  char* seen;           /* marks for conflict analysis */
+  int* learnt_lits;     /* buffer for the learnt clause */
+  int* to_clear;        /* buffer for the marked variables */
+  long nb_conflicts;
+  double max_learnts;
+  volatile bool* interrupt; /* sat_solve gives up once it is true (or NULL) */
+};
+
+/* *********************************************************** */
+
+static int _lit(int dimacs) {
+  return dimacs > 0 ? 2 * (dimacs - 1) : 2 * (-dimacs - 1) + 1;
+}
+
+/* *********************************************************** */
+
+static int _value(const sat* s, int l) {
+  int v = s->values[l >> 1];
+  return (l & 1) ? -v : v;
+}
+
+/* *********************************************************** */
+
+static void _vec_push(clause_vec* vec, clause* c) {
+  if (vec->len == vec->capacity) {
+    vec->capacity = vec->capacity ? 2 * vec->capacity : 4;
+    vec->data = realloc(vec->data, vec->capacity * sizeof(clause*));
+    assert(vec->data);
+  }
+  vec->data[vec->len++] = c;
+}
+
+/* *********************************************************** */
+
+static void _vec_remove(clause_vec* vec, clause* c) {
+  int k = 0;
+  while (vec->data[k] != c) k++;
+  vec->data[k] = vec->data[--vec->len];
+}
+
+/* *********************************************************** */
+/*                         VARIABLE HEAP                       */
+/* *********************************************************** */
+
+static bool _heap_before(const sat* s, int u, int v) {
+  return s->activity[u] > s->activity[v];
+}
+
+/* *********************************************************** */
+
+static void _heap_up(sat* s, int k) {
+  int v = s->heap[k];
+  while (k > 0 && _heap_before(s, v, s->heap[(k - 1) / 2])) {
+    s->heap[k] = s->heap[(k - 1) / 2];
+    s->heap_pos[s->heap[k]] = k;
+    k = (k - 1) / 2;
+  }
+  s->heap[k] = v;
+  s->heap_pos[v] = k;
+}
+
+/* *********************************************************** */
+
+static void _heap_down(sat* s, int k) {
+  int v = s->heap[k];
+  for (;;) {
+    int child = 2 * k + 1;
+    if (child >= s->heap_len) break;
+    if (child + 1 < s->heap_len &&
+        _heap_before(s, s->heap[child + 1], s->heap[child]))
+      child++;
+    if (!_heap_before(s, s->heap[child], v)) break;
+    s->heap[k] = s->heap[child];
+    s->heap_pos[s->heap[k]] = k;
+    k = child;
+  }
+  s->heap[k] = v;
+  s->heap_pos[v] = k;
+}
+
+/* *********************************************************** */
+
+static void _heap_insert(sat* s, int v) {
+  if (s->heap_pos[v] >= 0) return;
+  s->heap[s->heap_len] = v;
+  _heap_up(s, s->heap_len++);
+}
+
+/* *********************************************************** */
+
+static int _heap_pop(sat* s) {
+  int v = s->heap[0];
+  s->heap_pos[v] = -1;
+  if (--s->heap_len > 0) {
+    s->heap[0] = s->heap[s->heap_len];
+    _heap_down(s, 0);
+  }
+  return v;
+}
+
+/* *********************************************************** */
+/*                          ACTIVITIES                         */
+/* *********************************************************** */
+
+static void _bump_var(sat* s, int v) {
+  if ((s->activity[v] += s->var_inc) > 1e100) {
+    for (int u = 0; u < s->nb_vars; u++) s->activity[u] *= 1e-100;
+    s->var_inc *= 1e-100;
+  }
+  if (s->heap_pos[v] >= 0) _heap_up(s, s->heap_pos[v]);
+}
+
+/* *********************************************************** */
+
+static void _bump_clause(sat* s, clause* c) {
+  if ((c->activity += s->clause_inc) > 1e20) {
+    for (int k = 0; k < s->learnts.len; k++)
+      s->learnts.data[k]->activity *= 1e-20;
+    s->clause_inc *= 1e-20;
+  }
+}
+
+/* *********************************************************** */
+/*                            TRAIL                            */
+/* *********************************************************** */
+
+static void _enqueue(sat* s, int l, clause* reason) {
+  int v = l >> 1;
+  s->values[v] = (l & 1) ? -1 : 1;
+  s->levels[v] = s->nb_levels;
+  s->reasons[v] = reason;
+  s->trail[s->trail_len++] = l;
+}
+
+/* *********************************************************** */
+
+static void _cancel_until(sat* s, int level) {
+  if (s->nb_levels <= level) return;
+  for (int k = s->trail_len - 1; k >= s->trail_lim[level]; k--) {
+    int v = s->trail[k] >> 1;
+    s->phase[v] = s->trail[k] & 1;
+    s->values[v] = 0;
+    s->reasons[v] = NULL;
+    _heap_insert(s, v);
+  }
+  s->trail_len = s->qhead = s->trail_lim[level];
+  s->nb_levels = level;
+}
+
+/* *********************************************************** */
+/*                           CLAUSES                           */
+/* *********************************************************** */
+
+static clause* _clause_new(const int* lits, int len, bool learnt) {
+  clause* c = malloc(sizeof(clause) + len * sizeof(int));
+  assert(c);
+  c->size = len;
+  c->learnt = learnt;
+  c->activity = 0;
+  for (int k = 0; k < len; k++) c->lits[k] = lits[k];
+  return c;
+}
+
+/* *********************************************************** */
+
+static void _attach(sat* s, clause* c) {
+  _vec_push(&s->watches[c->lits[0]], c);
+  _vec_push(&s->watches[c->lits[1]], c);
+}
+
+/* *********************************************************** */
+
+static void _detach(sat* s, clause* c) {
+  _vec_remove(&s->watches[c->lits[0]], c);
+  _vec_remove(&s->watches[c->lits[1]], c);
+}
+
+/* *********************************************************** */
+
+/* a clause is locked while it is the reason of its first literal */
+static bool _locked(const sat* s, const clause* c) {
+  return s->reasons[c->lits[0] >> 1] == c && _value(s, c->lits[0]) == 1;
+}
+
+/* *********************************************************** */
+
+static int _compare_activity(const void* a, const void* b) {
+  double x = (*(clause* const*)a)->activity;
+  double y = (*(clause* const*)b)->activity;
+  return (x > y) - (x < y);
+}
+
+/* *********************************************************** */
+
+/* remove about half of the learnt clauses, the least active first */
+static void _reduce_learnts(sat* s) {
+  clause_vec* l = &s->learnts;
+  qsort(l->data, l->len, sizeof(clause*), _compare_activity);
+  double limit = s->clause_inc / l->len;
+  int kept = 0;
+  for (int k = 0; k < l->len; k++) {
+    clause* c = l->data[k];
+    bool useless = (k < l->len / 2 || c->activity < limit);
+    if (c->size > 2 && !_locked(s, c) && useless) {
+      _detach(s, c);
+      free(c);
+    } else
+      l->data[kept++] = c;
+  }
+  l->len = kept;
+}
+
+/* *********************************************************** */
+/*                         PROPAGATION                         */
+/* *********************************************************** */
+
+/* propagate the trail, returns the conflicting clause (or NULL) */
+static clause* _propagate(sat* s) {
+  clause* conflict = NULL;
+  while (s->qhead < s->trail_len && !conflict) {
+    int false_lit = s->trail[s->qhead++] ^ 1;
+    clause_vec* ws = &s->watches[false_lit];
+    int i = 0, j = 0;
+    while (i < ws->len) {
+      clause* c = ws->data[i++];
+      // the false literal goes to position 1
+      if (c->lits[0] == false_lit) {
+        c->lits[0] = c->lits[1];
+        c->lits[1] = false_lit;
+      }
+      if (_value(s, c->lits[0]) == 1) {
+        ws->data[j++] = c;
+        continue;
+      }
+      // look for another literal to watch
+      bool moved = false;
+      for (int k = 2; k < c->size && !moved; k++)
+        if (_value(s, c->lits[k]) != -1) {
+          c->lits[1] = c->lits[k];
+          c->lits[k] = false_lit;
+          _vec_push(&s->watches[c->lits[1]], c);
+          moved = true;
+        }
+      if (moved) continue;
+      // the clause is unit or conflicting
+      ws->data[j++] = c;
+      if (_value(s, c->lits[0]) == -1) {
+        conflict = c;
+        while (i < ws->len) ws->data[j++] = ws->data[i++];
+      } else
+        _enqueue(s, c->lits[0], c);
+    }
+    ws->len = j;
+  }
+  if (conflict) s->qhead = s->trail_len;
+  return conflict;
+}
+
+/* *********************************************************** */
+/*                      CONFLICT ANALYSIS                      */
+/* *********************************************************** */
+
+/* can literal l be removed from the learnt clause? (its reason only holds
+ * literals of the clause or fixed at level 0) */
+static bool _redundant(const sat* s, int l) {
+  const clause* r = s->reasons[l >> 1];
+  if (!r) return false;
+  for (int k = 1; k < r->size; k++) {
+    int v = r->lits[k] >> 1;
+    if (!s->seen[v] && s->levels[v] > 0) return false;
+  }
+  return true;
+}
+
+/* *********************************************************** */
+
+/* first UIP learning, returns the size of the learnt clause (in learnt_lits,
+ * asserting literal first) and sets the level to backtrack to */
+static int _analyze(sat* s, clause* conflict, int* backtrack_level) {
+  int* learnt = s->learnt_lits;
+  int len = 1, nb_clear = 0, path = 0, p = -1;
+  int index = s->trail_len - 1;
+  do {
+    if (conflict->learnt) _bump_clause(s, conflict);
+    for (int k = (p == -1) ? 0 : 1; k < conflict->size; k++) {
+      int q = conflict->lits[k], v = q >> 1;
+      if (s->seen[v] || s->levels[v] == 0) continue;
+      _bump_var(s, v);
+      s->seen[v] = 1;
+      s->to_clear[nb_clear++] = v;
+      if (s->levels[v] >= s->nb_levels)
+        path++;
+      else
+        learnt[len++] = q;
+    }
+    while (!s->seen[s->trail[index] >> 1]) index--;
+    p = s->trail[index--];
+    conflict = s->reasons[p >> 1];
+    s->seen[p >> 1] = 0;
+    path--;
+  } while (path > 0);
+  learnt[0] = p ^ 1;
+
+  // drop the literals implied by the others
+  int kept = 1;
+  for (int k = 1; k < len; k++)
+    if (!_redundant(s, learnt[k])) learnt[kept++] = learnt[k];
+  len = kept;
+  for (int k = 0; k < nb_clear; k++) s->seen[s->to_clear[k]] = 0;
+
+  // the literal of the highest level goes to position 1
+  *backtrack_level = 0;
+  for (int k = 1; k < len; k++) {
+    int level = s->levels[learnt[k] >> 1];
+    if (level > *backtrack_level) {
+      *backtrack_level = level;
+      int tmp = learnt[1];
+      learnt[1] = learnt[k];
+      learnt[k] = tmp;
+    }
+  }
+  return len;
+}
+
+/* *********************************************************** */
+/*                            SEARCH                           */
+/* *********************************************************** */
+
+/* Luby sequence: 1 1 2 1 1 2 4 1 1 2 ... */
+static long _luby(int k) {
+  int size = 1, seq = 0;
+  while (size < k + 1) {
+    seq++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != k) {
+    size = (size - 1) / 2;
+    seq--;
+    k %= size;
+  }
+  return 1L << seq;
+}
+
+/* *********************************************************** */
+
+/* search until a model is found, the clauses are refuted, the interrupt flag
+ * is set, or max_conflicts conflicts happened (returns -1 in this last case) */
+static int _search(sat* s, long max_conflicts) {
+  long nb_conflicts = 0;
+  for (;;) {
+    if (s->interrupt && *s->interrupt) {
+      _cancel_until(s, 0);
+      return SAT_UNKNOWN;
+    }
+    clause* conflict = _propagate(s);
+    if (conflict) {
+      s->nb_conflicts++;
+      nb_conflicts++;
+      if (s->nb_levels == 0) return SAT_UNSAT;
+      int level;
+      int len = _analyze(s, conflict, &level);
+      _cancel_until(s, level);
+      if (len == 1)
+        _enqueue(s, s->learnt_lits[0], NULL);
+      else {
+        clause* c = _clause_new(s->learnt_lits, len, true);
+        _vec_push(&s->learnts, c);
+        _attach(s, c);
+        _bump_clause(s, c);
+        _enqueue(s, c->lits[0], c);
+      }
+      s->var_inc /= VAR_DECAY;
+      s->clause_inc /= CLAUSE_DECAY;
+      continue;
+    }
+    if (nb_conflicts >= max_conflicts) {
+      _cancel_until(s, 0);
+      return -1;
+    }
+    if (s->learnts.len - s->trail_len >= s->max_learnts) _reduce_learnts(s);
+
+    // branch on the most active unassigned variable
+    int v = -1;
+    while (s->heap_len > 0 && v < 0) {
+      v = _heap_pop(s);
+      if (s->values[v] != 0) v = -1;
+    }
+    if (v < 0) return SAT_SAT;
+    s->trail_lim[s->nb_levels++] = s->trail_len;
+    _enqueue(s, 2 * v + s->phase[v], NULL);
+  }
+}
+
+/* *********************************************************** */
+/*                           INTERFACE                         */
+/* *********************************************************** */
+
+sat* sat_new(int nb_vars) {
+  assert(nb_vars >= 0);
+  sat* s = calloc(1, sizeof(sat));
+  assert(s);
+  int n = nb_vars > 0 ? nb_vars : 1;
+  s->nb_vars = nb_vars;
+  s->ok = true;
+  s->watches = calloc(2 * n, sizeof(clause_vec));
+  s->values = calloc(n, sizeof(signed char));
+  s->levels = calloc(n, sizeof(int));
+  s->reasons = calloc(n, sizeof(clause*));
+  s->trail = malloc(n * sizeof(int));
+  s->trail_lim = malloc(n * sizeof(int));
+  s->activity = calloc(n, sizeof(double));
+  s->heap = malloc(n * sizeof(int));
+  s->heap_pos = malloc(n * sizeof(int));
+  s->phase = malloc(n * sizeof(signed char));
+  s->seen = calloc(n, sizeof(char));
+  s->learnt_lits = malloc(n * sizeof(int));
+  s->to_clear = malloc(n * sizeof(int));
+  assert(s->watches && s->values && s->levels && s->reasons && s->trail);
+  assert(s->trail_lim && s->activity && s->heap && s->heap_pos && s->phase);
+  assert(s->seen && s->learnt_lits && s->to_clear);
+  s->var_inc = s->clause_inc = 1;
+  for (int v = 0; v < nb_vars; v++) {
+    s->heap_pos[v] = -1;
+    s->phase[v] = 1;  // false first
+    _heap_insert(s, v);
+  }
+  return s;
+}
+
+/* *********************************************************** */
+
+bool sat_add_clause(sat* s, const int* lits, int len) {
+  assert(s && (lits || len == 0));
+  if (!s->ok) return false;
+  _cancel_until(s, 0);
+  int* c = malloc((len > 0 ? len : 1) * sizeof(int));
+  assert(c);
+  int size = 0;
+  for (int k = 0; k < len; k++) {
+    assert(lits[k] != 0 && abs(lits[k]) <= s->nb_vars);
+    int l = _lit(lits[k]);
+    int value = _value(s, l);
+    bool skip = (value == -1);  // false at level 0
+    for (int q = 0; q < size && !skip; q++) {
+      if (c[q] == (l ^ 1)) value = 1;  // tautology
+      if (c[q] == l) skip = true;     // duplicate
+    }
+    if (value == 1) {
+      free(c);
+      return true;
+    }
+    if (!skip) c[size++] = l;
+  }
+  if (size == 0)
+    s->ok = false;
+  else if (size == 1) {
+    _enqueue(s, c[0], NULL);
+    s->ok = (_propagate(s) == NULL);
+  } else {
+    clause* cl = _clause_new(c, size, false);
+    _vec_push(&s->clauses, cl);
+    _attach(s, cl);
+  }
+  free(c);
+  return s->ok;
+}
+
+/* *********************************************************** */
+
+void sat_set_interrupt(sat* s, volatile bool* flag) {
+  assert(s);
+  s->interrupt = flag;
+}
+
+/* *********************************************************** */
+
+sat_result sat_solve(sat* s) {
+  assert(s);
+  if (!s->ok) return SAT_UNSAT;
+  _cancel_until(s, 0);
+  if (s->max_learnts < s->clauses.len / 3.0)
+    s->max_learnts = s->clauses.len / 3.0;
+  if (s->max_learnts < 1000) s->max_learnts = 1000;
+  for (int restart = 0;; restart++) {
+    int result = _search(s, RESTART_BASE * _luby(restart));
+    if (result == SAT_UNSAT) s->ok = false;
+    if (result >= 0) return result;
+    s->max_learnts *= 1.05;
+  }
+}
+
+/* *********************************************************** */
+
+bool sat_value(const sat* s, int v) {
+  assert(s && v >= 1 && v <= s->nb_vars);
+  return s->values[v - 1] == 1;
+}
+
+/* *********************************************************** */
+
+long sat_nb_conflicts(const sat* s) {
+  assert(s);
+  return s->nb_conflicts;
+}
+
+/* *********************************************************** */
+
+void sat_delete(sat* s) {
+  if (!s) return;
+  for (int k = 0; k < s->clauses.len; k++) free(s->clauses.data[k]);
+  for (int k = 0; k < s->learnts.len; k++) free(s->learnts.data[k]);
+  free(s->clauses.data);
+  free(s->learnts.data);
+  int n = s->nb_vars > 0 ? s->nb_vars : 1;
+  for (int l = 0; l < 2 * n; l++) free(s->watches[l].data);
+  free(s->watches);
+  free(s->values);
+  free(s->levels);
+  free(s->reasons);
+  free(s->trail);
+  free(s->trail_lim);
+  free(s->activity);
+  free(s->heap);
+  free(s->heap_pos);
+  free(s->phase);
+  free(s->seen);
+  free(s->learnt_lits);
+  free(s->to_clear);
+  free(s);
+}
+
+/* *********************************************************** */
@@ -0,0 +1,52 @@
+/**
+ * @brief Lightweight CDCL SAT solver.
+ * @details Conflict-driven clause learning with two watched literals, VSIDS
+ * branching, phase saving, Luby restarts and learnt clause deletion.
+ * Literals follow the DIMACS convention: variables are numbered from 1, and
+ * -v is the negation of v. Clauses can be added between two calls to
+ * sat_solve, so that constraints can be generated lazily from a model.
+ **/
+
+#ifndef SAT_H
+#define SAT_H
+
+#include <stdbool.h>
+
+//@{
+
+typedef struct sat_s sat;
+
+/** Result of sat_solve. */
+typedef enum {
+  SAT_UNSAT = 0,   /**< the clauses have no model */
+  SAT_SAT = 1,     /**< a model was found, see sat_value */
+  SAT_UNKNOWN = 2, /**< the search was interrupted, see sat_set_interrupt */
+} sat_result;
+
+/** Creates a new solver with nb_vars variables and no clause. */
+sat* sat_new(int nb_vars);
+
+/** Adds the clause made of the len literals lits. Returns false if the
+ * clauses are now known to have no model. */
+bool sat_add_clause(sat* s, const int* lits, int len);
+
+/** Makes sat_solve give up, returning SAT_UNKNOWN, as soon as *flag is true
+ * (NULL to never give up). The flag can be set by another thread. */
+void sat_set_interrupt(sat* s, volatile bool* flag);
+
+/** Searches a model of the clauses added so far. */
+sat_result sat_solve(sat* s);
+
+/** Returns the value of variable v in the model found by the last call to
+ * sat_solve (only valid until the next clause is added). */
+bool sat_value(const sat* s, int v);
+
+/** Returns the number of conflicts met so far. */
+long sat_nb_conflicts(const sat* s);
+
+/** Frees the memory allocated for the solver. */
+void sat_delete(sat* s);
+
+//@}
+
+#endif  // SAT_H